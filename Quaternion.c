@@ -15,11 +15,12 @@
 /**
  * @file    Quaternion.c
  * @brief   A basic quaternion library written in C
- * @date    2022-05-16
+ * @date    2026-10-19
  */
 #include "Quaternion.h"
 #include <stdlib.h>
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -46,6 +47,21 @@ void Quaternion_copy(Quaternion* q, Quaternion* output)
     Quaternion_set(q->w, q->v[0], q->v[1], q->v[2], output);
 }
 
+void Quaternion_load(QuaternionArray* array, size_t index, Quaternion* output)
+{
+    assert(output != NULL);
+    Quaternion_set(array->w[index], array->v[0][index], array->v[1][index], array->v[2][index], output);
+}
+
+void Quaternion_store(Quaternion* q, QuaternionArray* output, size_t index)
+{
+    assert(output != NULL);
+    output->w[index] = q->w;
+    output->v[0][index] = q->v[0];
+    output->v[1][index] = q->v[1];
+    output->v[2][index] = q->v[2];
+}
+
 bool Quaternion_equal(Quaternion* q1, Quaternion* q2)
 {
     bool equalW  = fabs(q1->w - q2->w) <= QUATERNION_EPS;
@@ -136,18 +152,24 @@ void Quaternion_toEulerZYX(Quaternion* q, double output[3])
 {
     assert(output != NULL);
 
+    // Pitch (y-axis rotation)
+    double sinp = +2.0 * (q->w * q->v[1] - q->v[2] * q->v[0]);
+    if (fabs(sinp) >= 1 - 4 * DBL_EPSILON) {
+        // Gimbal lock: roll and yaw rotate around the same axis and cannot
+        // be separated, so the whole rotation is assigned to yaw
+        double s = (q->w < 0) ? -1.0 : 1.0;
+        output[0] = 0;
+        output[1] = copysign(M_PI / 2, sinp);
+        output[2] = 2.0 * atan2(s * q->v[2], s * q->w);
+        return;
+    }
+    output[1] = asin(sinp);
+
     // Roll (x-axis rotation)
     double sinr_cosp = +2.0 * (q->w * q->v[0] + q->v[1] * q->v[2]);
     double cosr_cosp = +1.0 - 2.0 * (q->v[0] * q->v[0] + q->v[1] * q->v[1]);
     output[0] = atan2(sinr_cosp, cosr_cosp);
 
-    // Pitch (y-axis rotation)
-    double sinp = +2.0 * (q->w * q->v[1] - q->v[2] * q->v[0]);
-    if (fabs(sinp) >= 1)
-        output[1] = copysign(M_PI / 2, sinp); // use 90 degrees if out of range
-    else
-        output[1] = asin(sinp);
-
     // Yaw (z-axis rotation)
     double siny_cosp = +2.0 * (q->w * q->v[2] + q->v[0] * q->v[1]);
     double cosy_cosp = +1.0 - 2.0 * (q->v[1] * q->v[1] + q->v[2] * q->v[2]);
@@ -172,15 +194,29 @@ double Quaternion_norm(Quaternion* q)
 void Quaternion_normalize(Quaternion* q, Quaternion* output)
 {
     assert(output != NULL);
-    double len = Quaternion_norm(q);
+    Quaternion scaled = *q;
+    double len = Quaternion_norm(&scaled);
+    if (len < 0x1p-450) {
+        // Squares of tiny (e.g., denormal) values underflow: scale up first.
+        // Afterwards, even the smallest denormal squares to a normal number.
+        Quaternion_set(q->w * 0x1p600, q->v[0] * 0x1p600, q->v[1] * 0x1p600, q->v[2] * 0x1p600, &scaled);
+        len = Quaternion_norm(&scaled);
+    }
     Quaternion_set(
-        q->w / len,
-        q->v[0] / len,
-        q->v[1] / len,
-        q->v[2] / len,
+        scaled.w / len,
+        scaled.v[0] / len,
+        scaled.v[1] / len,
+        scaled.v[2] / len,
         output);
 }
 
+void Quaternion_normalizeFast(Quaternion* q, Quaternion* output)
+{
+    assert(output != NULL);
+    double s = Quaternion_fastInverseSqrt(q->w*q->w + q->v[0]*q->v[0] + q->v[1]*q->v[1] + q->v[2]*q->v[2]);
+    Quaternion_set(q->w * s, q->v[0] * s, q->v[1] * s, q->v[2] * s, output);
+}
+
 void Quaternion_multiply(Quaternion* q1, Quaternion* q2, Quaternion* output)
 {
     assert(output != NULL);
@@ -270,4 +306,697 @@ void Quaternion_slerp(Quaternion* q1, Quaternion* q2, double t, Quaternion* outp
         result.v[2] = (q1->v[2] * ratioA + q2->v[2] * ratioB);
     }
     *output = result;
-}
\ No newline at end of file
+}
+
+/*
+ * Small angle expansions. Below the thresholds, the first omitted term of
+ * the Taylor series is smaller than the double precision epsilon.
+ */
+
+// sin(x) / x
+static inline double sinc(double x)
+{
+    double x2 = x * x;
+    return (x2 < 5e-5) ? 1.0 - x2 / 6.0 * (1.0 - x2 / 20.0) : sin(x) / x;
+}
+
+// atan2(y, x) / y for y >= 0
+static inline double atan2DivY(double y, double x)
+{
+    if (x > 0 && y < 2e-3 * x) {
+        double r2 = (y / x) * (y / x);
+        return (1.0 - r2 / 3.0 * (1.0 - r2 * 0.6)) / x;
+    }
+    return atan2(y, x) / y;
+}
+
+/*
+ * Branch-free helpers for the batch functions. In contrast to calls of the
+ * math library (even floor and fmax), compilers can vectorize loops that use
+ * them. Only sqrt remains, which needs -fno-math-errno to be vectorized.
+ * All cases are chosen with Quaternion_select() instead of the conditional
+ * operator, which GCC does not vectorize with the default -ftrapping-math.
+ * Polynomial coefficients are from fdlibm (Sun Microsystems, 1993).
+ */
+
+// Clamps x to the smallest positive normal number, to allow divisions by x
+static inline double positive(double x)
+{
+    return Quaternion_select(x > DBL_MIN, x, DBL_MIN);
+}
+
+// sin(x) and cos(x) for |x| < 1e5 (error within a few ULP)
+static inline void polySinCos(double x, double* s, double* c)
+{
+    // Reduce to r in [-pi/4, pi/4] with x = k * pi/2 + r. Adding 1.5 * 2^52
+    // rounds to an integer, whose low bits are the quadrant. In contrast to a
+    // conversion to int, this is defined for all x and vectorizes with doubles.
+    union { double d; int64_t i; } rounded = { x * 0.636619772367581343076 + 0x1.8p52 };
+    int64_t quadrant = rounded.i;
+    double k = rounded.d - 0x1.8p52;
+    double r = (x - k * 1.57079632673412561417e+00) - k * 6.07710050650619224932e-11;
+
+    double z = r * r;
+    double sinR = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03
+        + z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06
+        + z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+    double cosR = 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03
+        + z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07
+        + z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+
+    // Quadrants: (sin, cos) = (s, c), (c, -s), (-s, -c), (-c, s)
+    bool swap = quadrant & 1;
+    double sinSign = Quaternion_select(quadrant & 2, -1.0, 1.0);
+    double cosSign = Quaternion_select((quadrant + 1) & 2, -1.0, 1.0);
+    *s = sinSign * Quaternion_select(swap, cosR, sinR);
+    *c = cosSign * Quaternion_select(swap, sinR, cosR);
+}
+
+// atan2(y, x) for y >= 0 (error within a few ULP)
+static inline double polyAtan2(double y, double x)
+{
+    double ax = fabs(x);
+    double lo = Quaternion_select(y < ax, y, ax);
+    double hi = Quaternion_select(y < ax, ax, y);
+    double a = lo / positive(hi);
+
+    // atan(a) = pi/4 + atan((a - 1) / (a + 1)) reduces a to [0, tan(pi/8)]
+    bool reduce = a > 0.41421356237309504880;
+    double reduced = (a - 1.0) / (a + 1.0);
+    double t = Quaternion_select(reduce, reduced, a);
+    double z = t * t;
+    double p = z * (3.33333333333329318027e-01 + z * (-1.99999999998764832476e-01
+        + z * (1.42857142725034663711e-01 + z * (-1.11111104054623557880e-01
+        + z * (9.09088713343650656196e-02 + z * (-7.69187620504482999495e-02
+        + z * (6.66107313738753120669e-02 + z * (-5.83357013379057348645e-02
+        + z * (4.97687799461593236017e-02 + z * (-3.65315727442169155270e-02
+        + z * 1.62858201153657823623e-02))))))))));
+    double angle = Quaternion_select(reduce, M_PI / 4, 0.0) + (t - t * p);
+
+    angle = Quaternion_select(y > ax, M_PI / 2 - angle, angle);
+    return Quaternion_select(x < 0, M_PI - angle, angle);
+}
+
+void Quaternion_exp(Quaternion* q, Quaternion* output)
+{
+    assert(output != NULL);
+    // exp(w, v) = e^w * (cos|v|, sin|v| * v / |v|)
+    double len = sqrt(q->v[0]*q->v[0] + q->v[1]*q->v[1] + q->v[2]*q->v[2]);
+    double ew = exp(q->w);
+    double c = ew * sinc(len);
+    Quaternion_set(ew * cos(len), c * q->v[0], c * q->v[1], c * q->v[2], output);
+}
+
+void Quaternion_log(Quaternion* q, Quaternion* output)
+{
+    assert(output != NULL);
+    // log(w, v) = (ln|q|, atan2(|v|, w) * v / |v|)
+    double len = sqrt(q->v[0]*q->v[0] + q->v[1]*q->v[1] + q->v[2]*q->v[2]);
+    double lnNorm = 0.5 * log(q->w*q->w + len*len);
+    if (len == 0.0 && q->w < 0) {
+        // Rotation by 360 degrees: arbitrary normalized axis
+        Quaternion_set(lnNorm, M_PI, 0, 0, output);
+        return;
+    }
+    double c = (len == 0.0) ? 1.0 / q->w : atan2DivY(len, q->w);
+    Quaternion_set(lnNorm, c * q->v[0], c * q->v[1], c * q->v[2], output);
+}
+
+void Quaternion_pow(Quaternion* q, double t, Quaternion* output)
+{
+    assert(output != NULL);
+    Quaternion l;
+    Quaternion_log(q, &l);
+    Quaternion_set(t * l.w, t * l.v[0], t * l.v[1], t * l.v[2], &l);
+    Quaternion_exp(&l, output);
+}
+
+void Quaternion_boxplus(Quaternion* q, double delta[3], Quaternion* output)
+{
+    assert(output != NULL);
+    Quaternion d;
+    Quaternion_set(0, 0.5 * delta[0], 0.5 * delta[1], 0.5 * delta[2], &d);
+    Quaternion_exp(&d, &d);
+    Quaternion_multiply(q, &d, output);
+}
+
+void Quaternion_boxminus(Quaternion* q1, Quaternion* q2, double output[3])
+{
+    assert(output != NULL);
+    Quaternion d;
+    Quaternion_conjugate(q2, &d);
+    Quaternion_multiply(&d, q1, &d);
+    // q and -q are the same rotation: use the shorter one
+    double s = (d.w < 0) ? -1.0 : 1.0;
+    double len = sqrt(d.v[0]*d.v[0] + d.v[1]*d.v[1] + d.v[2]*d.v[2]);
+    double c = (len == 0.0) ? 2.0 : 2.0 * s * atan2DivY(len, s * d.w);
+    output[0] = c * d.v[0];
+    output[1] = c * d.v[1];
+    output[2] = c * d.v[2];
+}
+
+void Quaternion_expArray(double* v[3], size_t count, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* vx = v[0];
+    const double* vy = v[1];
+    const double* vz = v[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double x = vx[i], y = vy[i], z = vz[i];
+        double len2 = x*x + y*y + z*z;
+        double len = sqrt(len2);
+        double s, c;
+        polySinCos(len, &s, &c);
+        double series = 1.0 - len2 / 6.0 * (1.0 - len2 / 20.0);
+        double exact = s / positive(len);
+        double f = Quaternion_select(len2 < 5e-5, series, exact);
+        ow[i] = c;
+        ox[i] = f * x;
+        oy[i] = f * y;
+        oz[i] = f * z;
+    }
+}
+
+void Quaternion_logArray(QuaternionArray* q, size_t count, double* output[3])
+{
+    assert(output != NULL);
+    const double* qw = q->w;
+    const double* qx = q->v[0];
+    const double* qy = q->v[1];
+    const double* qz = q->v[2];
+    double* ox = output[0];
+    double* oy = output[1];
+    double* oz = output[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+        double len2 = x*x + y*y + z*z;
+        double len = sqrt(len2);
+        double r2 = len2 / (w * w);
+        double series = (1.0 - r2 / 3.0 * (1.0 - r2 * 0.6)) / w;
+        double exact = polyAtan2(len, w) / positive(len);
+        double f = Quaternion_select((w > 0) & (r2 < 4e-6), series, exact);
+        // Rotation by 360 degrees: X-axis as in Quaternion_log()
+        ox[i] = Quaternion_select((len == 0) & (w < 0), M_PI, f * x);
+        oy[i] = f * y;
+        oz[i] = f * z;
+    }
+}
+
+void Quaternion_powArray(QuaternionArray* q, double* t, size_t count, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* qw = q->w;
+    const double* qx = q->v[0];
+    const double* qy = q->v[1];
+    const double* qz = q->v[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+        double len2 = x*x + y*y + z*z;
+        double len = sqrt(len2);
+
+        // Rotation angle of q^t is t times the one of q
+        double angle = polyAtan2(len, w);
+        double s, c;
+        polySinCos(t[i] * angle, &s, &c);
+        double f = s / positive(len);
+        ow[i] = c;
+        // Rotation by 360 degrees: X-axis as in Quaternion_log()
+        ox[i] = Quaternion_select((len == 0) & (w < 0), s, f * x);
+        oy[i] = f * y;
+        oz[i] = f * z;
+    }
+}
+
+void Quaternion_boxplusArray(QuaternionArray* q, double* delta[3], size_t count, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* qw = q->w;
+    const double* qx = q->v[0];
+    const double* qy = q->v[1];
+    const double* qz = q->v[2];
+    const double* deltaX = delta[0];
+    const double* deltaY = delta[1];
+    const double* deltaZ = delta[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double dx = 0.5 * deltaX[i], dy = 0.5 * deltaY[i], dz = 0.5 * deltaZ[i];
+        double len2 = dx*dx + dy*dy + dz*dz;
+        double len = sqrt(len2);
+        double s, c;
+        polySinCos(len, &s, &c);
+        double series = 1.0 - len2 / 6.0 * (1.0 - len2 / 20.0);
+        double exact = s / positive(len);
+        double f = Quaternion_select(len2 < 5e-5, series, exact);
+        double bw = c, bx = f * dx, by = f * dy, bz = f * dz;
+
+        // output = q * exp(delta / 2), see Quaternion_multiply
+        double aw = qw[i], ax = qx[i], ay = qy[i], az = qz[i];
+        ow[i] = aw*bw - ax*bx - ay*by - az*bz;
+        ox[i] = ax*bw + aw*bx + ay*bz - az*by;
+        oy[i] = aw*by - ax*bz + ay*bw + az*bx;
+        oz[i] = aw*bz + ax*by - ay*bx + az*bw;
+    }
+}
+
+void Quaternion_boxminusArray(QuaternionArray* q1, QuaternionArray* q2, size_t count, double* output[3])
+{
+    assert(output != NULL);
+    const double* q1w = q1->w;
+    const double* q1x = q1->v[0];
+    const double* q1y = q1->v[1];
+    const double* q1z = q1->v[2];
+    const double* q2w = q2->w;
+    const double* q2x = q2->v[0];
+    const double* q2y = q2->v[1];
+    const double* q2z = q2->v[2];
+    double* ox = output[0];
+    double* oy = output[1];
+    double* oz = output[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        // d = conj(q2) * q1
+        double aw = q2w[i], ax = -q2x[i], ay = -q2y[i], az = -q2z[i];
+        double bw = q1w[i], bx = q1x[i], by = q1y[i], bz = q1z[i];
+        double w = aw*bw - ax*bx - ay*by - az*bz;
+        double x = ax*bw + aw*bx + ay*bz - az*by;
+        double y = aw*by - ax*bz + ay*bw + az*bx;
+        double z = aw*bz + ax*by - ay*bx + az*bw;
+
+        // q and -q are the same rotation: use the shorter one
+        double s = Quaternion_select(w < 0, -2.0, 2.0);
+        w = fabs(w);
+        double len2 = x*x + y*y + z*z;
+        double len = sqrt(len2);
+        double r2 = len2 / (w * w);
+        double series = (1.0 - r2 / 3.0 * (1.0 - r2 * 0.6)) / w;
+        double exact = polyAtan2(len, w) / positive(len);
+        double f = Quaternion_select(r2 < 4e-6, series, exact);
+        ox[i] = s * f * x;
+        oy[i] = s * f * y;
+        oz[i] = s * f * z;
+    }
+}
+
+void Quaternion_rotateArray(QuaternionArray* q, double* v[3], size_t count, double* output[3])
+{
+    assert(output != NULL);
+    const double* qw = q->w;
+    const double* qx = q->v[0];
+    const double* qy = q->v[1];
+    const double* qz = q->v[2];
+    const double* vx = v[0];
+    const double* vy = v[1];
+    const double* vz = v[2];
+    double* ox = output[0];
+    double* oy = output[1];
+    double* oz = output[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w = qw[i], x = qx[i], y = qy[i], z = qz[i];
+        double px = vx[i], py = vy[i], pz = vz[i];
+        // Same formula as Quaternion_rotate()
+        double ww = w*w, xx = x*x, yy = y*y, zz = z*z;
+        double wx = w*x, wy = w*y, wz = w*z;
+        double xy = x*y, xz = x*z, yz = y*z;
+        ox[i] = (ww + xx - yy - zz)*px + 2*(xy - wz)*py + 2*(xz + wy)*pz;
+        oy[i] = 2*(xy + wz)*px + (ww - xx + yy - zz)*py + 2*(yz - wx)*pz;
+        oz[i] = 2*(xz - wy)*px + 2*(yz + wx)*py + (ww - xx - yy + zz)*pz;
+    }
+}
+
+// Scales a vector by a power of two, which is exact, such that an eighth of
+// the sum of its absolute components lies in [1, 2). Its squared length then
+// lies in [64/3, 256), so squares neither overflow nor underflow. Zero stays
+// zero.
+static inline void scaleDown(double* x, double* y, double* z)
+{
+    // An eighth of each term keeps the sum below 2^1023, whose reciprocal
+    // would be denormal. Negating the exponent avoids a division.
+    union { double d; uint64_t i; } scale = { positive(0.125 * fabs(*x) + 0.125 * fabs(*y) + 0.125 * fabs(*z)) };
+    scale.i = 0x7FE0000000000000 - (scale.i & 0x7FF0000000000000);
+    *x *= scale.d;
+    *y *= scale.d;
+    *z *= scale.d;
+}
+
+/*
+ * Rotation between two vectors with the half-vector trick: the quaternion
+ * (|a||b| + a.b, a x b) rotates a onto b by twice the wanted angle, halved by
+ * normalization. No trigonometric functions are needed. Near antiparallel
+ * inputs, |a||b| + a.b cancels and is computed as |a x b|^2 / (|a||b| - a.b).
+ */
+static inline void twoVectors(double ax, double ay, double az, double bx, double by, double bz,
+    double* w, double* x, double* y, double* z)
+{
+    scaleDown(&ax, &ay, &az);
+    scaleDown(&bx, &by, &bz);
+    double a2 = ax*ax + ay*ay + az*az;
+    double cx = ay*bz - az*by;
+    double cy = az*bx - ax*bz;
+    double cz = ax*by - ay*bx;
+
+    // The rounded cross product of nearly opposite vectors is not orthogonal
+    // to a, which would tilt a out of the rotation plane: project it back
+    double p = (cx*ax + cy*ay + cz*az) / positive(a2);
+    cx -= p * ax;
+    cy -= p * ay;
+    cz -= p * az;
+
+    double dot = ax*bx + ay*by + az*bz;
+    double cross2 = cx*cx + cy*cy + cz*cz;
+    double k = sqrt(a2 * (bx*bx + by*by + bz*bz));
+    double sum = k + dot;
+    double ratio = cross2 / positive(k - dot);
+    double s = Quaternion_select(dot >= 0, sum, ratio);
+
+    // Exactly antiparallel: rotate by 180 degrees around any axis orthogonal to a
+    bool antiparallel = (dot < 0) & (cross2 <= k * k * (DBL_EPSILON * DBL_EPSILON));
+    bool useX = fabs(ax) > fabs(az);
+    double ox = Quaternion_select(useX, -ay, 0);
+    double oy = Quaternion_select(useX, ax, -az);
+    double oz = Quaternion_select(useX, 0, ay);
+    double rw = Quaternion_select(antiparallel, 0, s);
+    double rx = Quaternion_select(antiparallel, ox, cx);
+    double ry = Quaternion_select(antiparallel, oy, cy);
+    double rz = Quaternion_select(antiparallel, oz, cz);
+
+    // Zero input vectors give the identity
+    double n2 = rw*rw + rx*rx + ry*ry + rz*rz;
+    double scale = 1.0 / sqrt(positive(n2));
+    bool zero = !(n2 > 0);
+    *w = Quaternion_select(zero, 1, rw * scale);
+    *x = Quaternion_select(zero, 0, rx * scale);
+    *y = Quaternion_select(zero, 0, ry * scale);
+    *z = Quaternion_select(zero, 0, rz * scale);
+}
+
+/*
+ * Look rotation from the orthonormal basis (right, up, forward) = columns of
+ * the rotation matrix, converted with Shepperd's method: the component with
+ * the largest magnitude is computed from the diagonal, the others from the
+ * off-diagonal elements. The case is chosen with selects instead of branches.
+ * The callers scale the inputs with scaleDown() first, outside of this
+ * function, so it stays small enough to be inlined into the loop.
+ */
+static inline void lookRotation(double fx, double fy, double fz, double ux, double uy, double uz,
+    double* w, double* x, double* y, double* z)
+{
+    // Forward (Z-axis)
+    double f2 = fx*fx + fy*fy + fz*fz;
+    double f = 1.0 / sqrt(positive(f2));
+    double zx = fx * f, zy = fy * f, zz = fz * f;
+
+    // Right (X-axis) = up x forward, any orthogonal axis if both are parallel
+    double xx = uy*zz - uz*zy;
+    double xy = uz*zx - ux*zz;
+    double xz = ux*zy - uy*zx;
+    double x2 = xx*xx + xy*xy + xz*xz;
+    double u2 = ux*ux + uy*uy + uz*uz;
+    bool parallel = x2 <= u2 * (DBL_EPSILON * DBL_EPSILON);
+    bool useX = fabs(zx) > fabs(zz);
+    xx = Quaternion_select(parallel, Quaternion_select(useX, -zy, 0), xx);
+    xy = Quaternion_select(parallel, Quaternion_select(useX, zx, -zz), xy);
+    xz = Quaternion_select(parallel, Quaternion_select(useX, 0, zy), xz);
+    double r = 1.0 / sqrt(positive(xx*xx + xy*xy + xz*xz));
+    xx *= r;
+    xy *= r;
+    xz *= r;
+
+    // Up (Y-axis) = forward x right
+    double yx = zy*xz - zz*xy;
+    double yy = zz*xx - zx*xz;
+    double yz = zx*xy - zy*xx;
+
+    // Matrix m[row][column] with the columns (x, y, z)
+    double m00 = xx, m01 = yx, m02 = zx;
+    double m10 = xy, m11 = yy, m12 = zy;
+    double m20 = xz, m21 = yz, m22 = zz;
+    double tw = m00 + m11 + m22;
+    double tx = m00 - m11 - m22;
+    double ty = m11 - m00 - m22;
+    double tz = m22 - m00 - m11;
+    bool caseW = (tw >= tx) & (tw >= ty) & (tw >= tz);
+    bool caseX = !caseW & (tx >= ty) & (tx >= tz);
+    bool caseY = !caseW & !caseX & (ty >= tz);
+    double t = Quaternion_select(caseW, tw, Quaternion_select(caseX, tx, Quaternion_select(caseY, ty, tz)));
+    double s = 2.0 * sqrt(1.0 + t);
+    double inv = 1.0 / s;
+    double big = 0.25 * s;
+
+    double dx = (m21 - m12) * inv;
+    double dy = (m02 - m20) * inv;
+    double dz = (m10 - m01) * inv;
+    double sxy = (m01 + m10) * inv;
+    double sxz = (m02 + m20) * inv;
+    double syz = (m12 + m21) * inv;
+    double rw = Quaternion_select(caseW, big, Quaternion_select(caseX, dx, Quaternion_select(caseY, dy, dz)));
+    double rx = Quaternion_select(caseW, dx, Quaternion_select(caseX, big, Quaternion_select(caseY, sxy, sxz)));
+    double ry = Quaternion_select(caseW, dy, Quaternion_select(caseX, sxy, Quaternion_select(caseY, big, syz)));
+    double rz = Quaternion_select(caseW, dz, Quaternion_select(caseX, sxz, Quaternion_select(caseY, syz, big)));
+
+    // A zero forward vector gives the identity
+    bool zero = !(f2 > 0);
+    *w = Quaternion_select(zero, 1, rw);
+    *x = Quaternion_select(zero, 0, rx);
+    *y = Quaternion_select(zero, 0, ry);
+    *z = Quaternion_select(zero, 0, rz);
+}
+
+void Quaternion_fromTwoVectors(double from[3], double to[3], Quaternion* output)
+{
+    assert(output != NULL);
+    twoVectors(from[0], from[1], from[2], to[0], to[1], to[2],
+        &output->w, &output->v[0], &output->v[1], &output->v[2]);
+}
+
+void Quaternion_lookRotation(double forward[3], double up[3], Quaternion* output)
+{
+    assert(output != NULL);
+    double fx = forward[0], fy = forward[1], fz = forward[2];
+    double ux = up[0], uy = up[1], uz = up[2];
+    scaleDown(&fx, &fy, &fz);
+    scaleDown(&ux, &uy, &uz);
+    lookRotation(fx, fy, fz, ux, uy, uz, &output->w, &output->v[0], &output->v[1], &output->v[2]);
+}
+
+void Quaternion_fromTwoVectorsArray(double* from[3], double* to[3], size_t count, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* ax = from[0];
+    const double* ay = from[1];
+    const double* az = from[2];
+    const double* bx = to[0];
+    const double* by = to[1];
+    const double* bz = to[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w, x, y, z;
+        twoVectors(ax[i], ay[i], az[i], bx[i], by[i], bz[i], &w, &x, &y, &z);
+        ow[i] = w;
+        ox[i] = x;
+        oy[i] = y;
+        oz[i] = z;
+    }
+}
+
+void Quaternion_lookRotationArray(double* forward[3], double* up[3], size_t count, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* fx = forward[0];
+    const double* fy = forward[1];
+    const double* fz = forward[2];
+    const double* ux = up[0];
+    const double* uy = up[1];
+    const double* uz = up[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w, x, y, z;
+        double ax = fx[i], ay = fy[i], az = fz[i];
+        double bx = ux[i], by = uy[i], bz = uz[i];
+        scaleDown(&ax, &ay, &az);
+        scaleDown(&bx, &by, &bz);
+        lookRotation(ax, ay, az, bx, by, bz, &w, &x, &y, &z);
+        ow[i] = w;
+        ox[i] = x;
+        oy[i] = y;
+        oz[i] = z;
+    }
+}
+
+void Quaternion_slerpArray(QuaternionArray* q1, QuaternionArray* q2, double* t, size_t count,
+    bool shortestPath, QuaternionArray* output)
+{
+    assert(output != NULL);
+    const double* aw = q1->w;
+    const double* ax = q1->v[0];
+    const double* ay = q1->v[1];
+    const double* az = q1->v[2];
+    const double* bw = q2->w;
+    const double* bx = q2->v[0];
+    const double* by = q2->v[1];
+    const double* bz = q2->v[2];
+    double* ow = output->w;
+    double* ox = output->v[0];
+    double* oy = output->v[1];
+    double* oz = output->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        double w1 = aw[i], x1 = ax[i], y1 = ay[i], z1 = az[i];
+        double w2 = bw[i], x2 = bx[i], y2 = by[i], z2 = bz[i];
+        double cosHalfTheta = w1*w2 + x1*x2 + y1*y2 + z1*z2;
+
+        // q and -q are the same rotation: optionally take the shorter arc
+        double sign = Quaternion_select(shortestPath & (cosHalfTheta < 0), -1.0, 1.0);
+        w2 *= sign;
+        x2 *= sign;
+        y2 *= sign;
+        z2 *= sign;
+        cosHalfTheta *= sign;
+
+        // Angle between q1 and q2 as 4D vectors, accurate also for tiny angles
+        double dw = w1 - w2, dx = x1 - x2, dy = y1 - y2, dz = z1 - z2;
+        double sw = w1 + w2, sx = x1 + x2, sy = y1 + y2, sz = z1 + z2;
+        double diff2 = dw*dw + dx*dx + dy*dy + dz*dz;
+        double sum2 = sw*sw + sx*sx + sy*sy + sz*sz;
+        double diff = sqrt(diff2), sum = sqrt(sum2);
+        double halfTheta = 2.0 * polyAtan2(diff, sum);
+
+        // sin(2 * atan2(diff, sum)) without a third sine
+        double sinHalfTheta = 2.0 * diff * sum / positive(diff2 + sum2);
+        double ti = t[i];
+        double sinA, sinB, unused;
+        polySinCos((1 - ti) * halfTheta, &sinA, &unused);
+        polySinCos(ti * halfTheta, &sinB, &unused);
+
+        // Blend instead of branches: nearly equal quaternions are interpolated
+        // linearly. Like Quaternion_slerp(), exactly opposite ones give q1 and
+        // nearly opposite ones the midpoint.
+        double inv = 1.0 / positive(sinHalfTheta);
+        bool degenerate = sinHalfTheta < 1e-8;
+        bool opposite = cosHalfTheta < 0;
+        bool exactlyOpposite = (cosHalfTheta <= -1.0) | !(sum2 > 0);
+        double ratioA = Quaternion_select(degenerate, Quaternion_select(opposite, 0.5, 1 - ti), sinA * inv);
+        double ratioB = Quaternion_select(degenerate, Quaternion_select(opposite, 0.5, ti), sinB * inv);
+        ratioA = Quaternion_select(exactlyOpposite, 1.0, ratioA);
+        ratioB = Quaternion_select(exactlyOpposite, 0.0, ratioB);
+
+        ow[i] = w1 * ratioA + w2 * ratioB;
+        ox[i] = x1 * ratioA + x2 * ratioB;
+        oy[i] = y1 * ratioA + y2 * ratioB;
+        oz[i] = z1 * ratioA + z2 * ratioB;
+    }
+}
+
+/*
+ * Swing-twist decomposition by projection: the twist is the quaternion
+ * (w, projection of v onto the axis), normalized, and the swing is what
+ * remains, q * conj(twist). No angles are computed, so the decomposition has
+ * no singularity except where the twist is undefined (swing of 180 degrees).
+ */
+static inline void swingTwist(double w, double x, double y, double z, double ax, double ay, double az,
+    Quaternion* swing, Quaternion* twist)
+{
+    scaleDown(&ax, &ay, &az);
+    double p = (x*ax + y*ay + z*az) / positive(ax*ax + ay*ay + az*az);
+    double tx = p * ax, ty = p * ay, tz = p * az;
+
+    // Choose the twist with w >= 0, i.e., a twist angle in [-pi, pi]
+    double norm2 = w*w + tx*tx + ty*ty + tz*tz;
+    bool degenerate = norm2 < DBL_MIN;
+    double s = Quaternion_select(w < 0, -1.0, 1.0) / sqrt(Quaternion_select(degenerate, 1.0, norm2));
+    twist->w = Quaternion_select(degenerate, 1.0, w * s);
+    twist->v[0] = Quaternion_select(degenerate, 0.0, tx * s);
+    twist->v[1] = Quaternion_select(degenerate, 0.0, ty * s);
+    twist->v[2] = Quaternion_select(degenerate, 0.0, tz * s);
+
+    // swing = q * conj(twist)
+    double cw = twist->w, cx = -twist->v[0], cy = -twist->v[1], cz = -twist->v[2];
+    swing->w    = w*cw - x*cx - y*cy - z*cz;
+    swing->v[0] = x*cw + w*cx + y*cz - z*cy;
+    swing->v[1] = w*cy - x*cz + y*cw + z*cx;
+    swing->v[2] = w*cz + x*cy - y*cx + z*cw;
+}
+
+void Quaternion_swingTwist(Quaternion* q, double axis[3], Quaternion* swing, Quaternion* twist)
+{
+    assert(swing != NULL);
+    assert(twist != NULL);
+    Quaternion s, t;
+    swingTwist(q->w, q->v[0], q->v[1], q->v[2], axis[0], axis[1], axis[2], &s, &t);
+    *swing = s;
+    *twist = t;
+}
+
+void Quaternion_fromSwingTwist(Quaternion* swing, Quaternion* twist, Quaternion* output)
+{
+    assert(output != NULL);
+    Quaternion_multiply(swing, twist, output);
+}
+
+void Quaternion_swingTwistArray(QuaternionArray* q, double* axis[3], size_t count,
+    QuaternionArray* swing, QuaternionArray* twist)
+{
+    assert(swing != NULL);
+    assert(twist != NULL);
+    const double* qw = q->w;
+    const double* qx = q->v[0];
+    const double* qy = q->v[1];
+    const double* qz = q->v[2];
+    const double* ax = axis[0];
+    const double* ay = axis[1];
+    const double* az = axis[2];
+    double* sw = swing->w;
+    double* sx = swing->v[0];
+    double* sy = swing->v[1];
+    double* sz = swing->v[2];
+    double* tw = twist->w;
+    double* tx = twist->v[0];
+    double* ty = twist->v[1];
+    double* tz = twist->v[2];
+
+    QUATERNION_INDEPENDENT_LOOP
+    for (size_t i = 0; i < count; i++) {
+        Quaternion s, t;
+        swingTwist(qw[i], qx[i], qy[i], qz[i], ax[i], ay[i], az[i], &s, &t);
+        sw[i] = s.w;
+        sx[i] = s.v[0];
+        sy[i] = s.v[1];
+        sz[i] = s.v[2];
+        tw[i] = t.w;
+        tx[i] = t.v[0];
+        ty[i] = t.v[1];
+        tz[i] = t.v[2];
+    }
+}
@@ -15,12 +15,14 @@
 /**
  * @file    Quaternion.h
  * @brief   A basic quaternion library written in C
- * @date    2019-11-28
+ * @date    2026-10-19
  */
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 
 /**
@@ -28,6 +30,20 @@
  */
 #define QUATERNION_EPS (1e-4)
 
+/**
+ * Placed before loops of batch functions, in which each iteration only
+ * accesses its own array elements. This allows the compiler to vectorize
+ * them without checking for overlapping arrays, while in-place operation
+ * (output arrays equal to input arrays) remains valid.
+ */
+#if defined(__clang__)
+    #define QUATERNION_INDEPENDENT_LOOP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+    #define QUATERNION_INDEPENDENT_LOOP _Pragma("GCC ivdep")
+#else
+    #define QUATERNION_INDEPENDENT_LOOP
+#endif
+
 /**
  * Data structure to hold a quaternion.
  */
@@ -36,6 +52,25 @@ typedef struct Quaternion {
     double v[3];    /**< Vector part */
 } Quaternion;
 
+/**
+ * Structure of arrays that holds many quaternions, used by batch functions.
+ * Every pointer refers to an array with one element per quaternion.
+ */
+typedef struct QuaternionArray {
+    double* w;      /**< Scalar parts */
+    double* v[3];   /**< Vector parts */
+} QuaternionArray;
+
+/**
+ * Allocates a zeroed array of count elements of the given size, used by the
+ * batch modules. At least one element is allocated, so NULL always signals
+ * an error, even for count == 0. Release the array with free().
+ */
+static inline void* Quaternion_allocateArray(size_t count, size_t size)
+{
+    return calloc((count > 0) ? count : 1, size);
+}
+
 /**
  * Sets the given values to the output quaternion.
  */
@@ -51,6 +86,16 @@ void Quaternion_setIdentity(Quaternion* q);
  */
 void Quaternion_copy(Quaternion* q, Quaternion* output);
 
+/**
+ * Copies the quaternion at the given index of an array to the output quaternion.
+ */
+void Quaternion_load(QuaternionArray* array, size_t index, Quaternion* output);
+
+/**
+ * Copies a quaternion to the given index of an array.
+ */
+void Quaternion_store(Quaternion* q, QuaternionArray* output, size_t index);
+
 /**
  * Tests if all quaternion values are equal (using QUATERNION_EPS).
  */
@@ -88,6 +133,8 @@ void Quaternion_fromEulerZYX(double eulerZYX[3], Quaternion* output);
 
 /**
  * Calculates the euler angles of a quaternion.
+ * At gimbal lock (pitch of +-90 degrees), roll is set to 0 and the combined
+ * rotation is returned as yaw.
  * @param output
  *      Euler angles in ZYX, but stored in array as [x'', y', z].
  */
@@ -121,10 +168,54 @@ void Quaternion_fromZRotation(double angle, Quaternion* output);
 double Quaternion_norm(Quaternion* q);
 
 /**
- * Normalizes the quaternion.
+ * Normalizes the quaternion. The zero quaternion gives NaN.
  */
 void Quaternion_normalize(Quaternion* q, Quaternion* output);
 
+/**
+ * Normalizes the quaternion with Quaternion_fastInverseSqrt() instead of a
+ * square root and divisions. The relative error of the norm is below 1e-10.
+ * Quaternions with a tiny (e.g., denormal) norm are not supported.
+ */
+void Quaternion_normalizeFast(Quaternion* q, Quaternion* output);
+
+/*
+ * Inline helpers for the batch functions. They are defined in the header,
+ * so loops over many values can inline them and be vectorized.
+ */
+
+/**
+ * Approximates 1 / sqrt(x) for positive normal x using a bit-level initial
+ * guess and three Newton iterations (relative error below 1e-10).
+ */
+static inline double Quaternion_fastInverseSqrt(double x)
+{
+    union { double d; int64_t i; } bits = { x };
+    bits.i = 0x5FE6EB50C7B537A9 - (bits.i >> 1);
+    double y = bits.d;
+    double halfX = 0.5 * x;
+    y = y * (1.5 - halfX * y * y);
+    y = y * (1.5 - halfX * y * y);
+    y = y * (1.5 - halfX * y * y);
+    return y;
+}
+
+/**
+ * Branch-free select: condition ? a : b
+ * In contrast to the conditional operator, both values are computed
+ * unconditionally. Compilers otherwise move arithmetic into the branches,
+ * where it might trap (-ftrapping-math is the default), and then cannot
+ * vectorize the loop. On x86-64, GCC needs 64-bit integer compares for the
+ * mask, i.e., SSE4.2 or later (e.g., -march=x86-64-v2 or -march=haswell).
+ */
+static inline double Quaternion_select(bool condition, double a, double b)
+{
+    union { double d; uint64_t i; } x = { a }, y = { b };
+    uint64_t mask = -(uint64_t)condition;
+    x.i = (x.i & mask) | (y.i & ~mask);
+    return x.d;
+}
+
 /**
  * Calculates the conjugate of the quaternion: (w, -v)
  */
@@ -151,3 +242,151 @@ void Quaternion_rotate(Quaternion* q, double v[3], double output[3]);
  *      0 is equal with q1, 1 is equal with q2, 0.5 is the middle between q1 and q2.
  */
 void Quaternion_slerp(Quaternion* q1, Quaternion* q2, double t, Quaternion* output);
+
+/**
+ * Calculates the quaternion exponential:
+ * exp(q) = e^w * (cos|v|, sin|v| * v / |v|)
+ */
+void Quaternion_exp(Quaternion* q, Quaternion* output);
+
+/**
+ * Calculates the quaternion logarithm:
+ * log(q) = (ln|q|, atan2(|v|, w) * v / |v|)
+ * For unit quaternions, the vector part is half the rotation vector (axis * angle / 2).
+ * Unlike Quaternion_toAxisAngle(), it stays accurate near the identity.
+ */
+void Quaternion_log(Quaternion* q, Quaternion* output);
+
+/**
+ * Raises the quaternion to a power: q^t = exp(t * log(q))
+ * For unit quaternions, this scales the rotation angle by t.
+ */
+void Quaternion_pow(Quaternion* q, double t, Quaternion* output);
+
+/**
+ * Applies a small rotation in the local frame of q: output = q * exp(delta / 2)
+ * @param delta
+ *      Rotation vector (axis * angle in radians).
+ */
+void Quaternion_boxplus(Quaternion* q, double delta[3], Quaternion* output);
+
+/**
+ * Calculates the rotation vector between two unit quaternions, such that
+ * Quaternion_boxplus(q2, output) equals q1 (up to sign).
+ * @param output
+ *      Rotation vector (axis * angle in radians) of the shortest rotation.
+ */
+void Quaternion_boxminus(Quaternion* q1, Quaternion* q2, double output[3]);
+
+/**
+ * Batch version of Quaternion_exp() for pure quaternions (0, v), i.e.,
+ * output[i] = exp(0, v[i]). Uses polynomial approximations without branches
+ * (error within a few ULP), so the loop can be vectorized by the compiler.
+ * GCC only vectorizes the square roots with -fno-math-errno. Rotation angles
+ * must be below 1e5 radians: larger angles lose accuracy, and beyond 1e15
+ * the result is meaningless (but defined).
+ */
+void Quaternion_expArray(double* v[3], size_t count, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_log() for unit quaternions. Only the vector part
+ * is returned, as the scalar part is zero. See Quaternion_expArray().
+ */
+void Quaternion_logArray(QuaternionArray* q, size_t count, double* output[3]);
+
+/**
+ * Batch version of Quaternion_pow() for unit quaternions: output[i] = q[i]^t[i]
+ * See Quaternion_expArray().
+ */
+void Quaternion_powArray(QuaternionArray* q, double* t, size_t count, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_boxplus(). See Quaternion_expArray().
+ */
+void Quaternion_boxplusArray(QuaternionArray* q, double* delta[3], size_t count, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_boxminus(). See Quaternion_expArray().
+ */
+void Quaternion_boxminusArray(QuaternionArray* q1, QuaternionArray* q2, size_t count, double* output[3]);
+
+/**
+ * Batch version of Quaternion_rotate(): output[i] = q[i] applied to v[i].
+ * The output arrays may be the input arrays.
+ */
+void Quaternion_rotateArray(QuaternionArray* q, double* v[3], size_t count, double* output[3]);
+
+/**
+ * Calculates the shortest rotation that turns the direction of from into the
+ * direction of to. Uses no trigonometric functions. The vectors do not need
+ * to be normalized and may have any finite length, down to denormal values.
+ * Antiparallel vectors give a rotation of 180 degrees around an axis
+ * orthogonal to from; a zero vector gives the identity.
+ */
+void Quaternion_fromTwoVectors(double from[3], double to[3], Quaternion* output);
+
+/**
+ * Calculates the orientation whose Z-axis points along forward and whose
+ * Y-axis points as close to up as possible. Uses no trigonometric functions.
+ * The vectors do not need to be normalized and may have any finite length,
+ * down to denormal values. If up is parallel to forward,
+ * an arbitrary Y-axis orthogonal to forward is used; a zero forward vector
+ * gives the identity.
+ */
+void Quaternion_lookRotation(double forward[3], double up[3], Quaternion* output);
+
+/**
+ * Splits a rotation into a twist around the given axis and a swing around an
+ * axis orthogonal to it, such that q = swing * twist (twist applied first).
+ * Uses projections instead of angles, so it has no gimbal lock. The twist has
+ * a non-negative w, i.e., a twist angle within [-pi, pi]. If the twist is
+ * undefined (a swing of 180 degrees), it is set to identity.
+ * @param axis
+ *      Twist axis, e.g., the bone direction. Does not need to be normalized
+ *      and may have any finite length. A zero axis gives the identity twist.
+ */
+void Quaternion_swingTwist(Quaternion* q, double axis[3], Quaternion* swing, Quaternion* twist);
+
+/**
+ * Combines swing and twist into one rotation, the inverse of
+ * Quaternion_swingTwist(): output = swing * twist
+ */
+void Quaternion_fromSwingTwist(Quaternion* swing, Quaternion* twist, Quaternion* output);
+
+/**
+ * Batch version of Quaternion_fromTwoVectors(), without branches, so the loop
+ * can be vectorized. Vectors of any finite length are supported; if from[i]
+ * or to[i] is zero, output[i] is the identity. GCC only vectorizes the square
+ * roots with -fno-math-errno.
+ */
+void Quaternion_fromTwoVectorsArray(double* from[3], double* to[3], size_t count, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_lookRotation(), without branches, so the loop
+ * can be vectorized. Vectors of any finite length are supported; if
+ * forward[i] is zero, output[i] is the identity. GCC only vectorizes the
+ * square roots with -fno-math-errno.
+ */
+void Quaternion_lookRotationArray(double* forward[3], double* up[3], size_t count, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_slerp(): output[i] = slerp(q1[i], q2[i], t[i])
+ * The special cases are blended in without branches, so the loop can be
+ * vectorized. Unlike Quaternion_slerp(), nearly equal quaternions are
+ * interpolated linearly instead of returning q1 or the midpoint.
+ * @param shortestPath
+ *      Whether to negate q2[i] if needed to interpolate along the shorter arc.
+ *      Otherwise exactly opposite quaternions give q1[i] and nearly opposite
+ *      ones their midpoint, as Quaternion_slerp() does.
+ */
+void Quaternion_slerpArray(QuaternionArray* q1, QuaternionArray* q2, double* t, size_t count,
+    bool shortestPath, QuaternionArray* output);
+
+/**
+ * Batch version of Quaternion_swingTwist() with one axis per element, without
+ * branches, so the loop can be vectorized. Axes of any finite length are
+ * supported; if axis[i] is zero, twist[i] is the identity. GCC only
+ * vectorizes the square roots with -fno-math-errno.
+ */
+void Quaternion_swingTwistArray(QuaternionArray* q, double* axis[3], size_t count,
+    QuaternionArray* swing, QuaternionArray* twist);
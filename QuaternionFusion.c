@@ -0,0 +1,329 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionFusion.c
+ * @brief   Madgwick and Mahony orientation filters for many sensors at once
+ * @date    2026-10-19
+ */
+#include "QuaternionFusion.h"
+#include <stdlib.h>
+#include <assert.h>
+
+/*
+ * Both filters are written as loops over all sensors without
+ * data-dependent branches: invalid readings are masked with a zero weight
+ * and normalizations use Quaternion_fastInverseSqrt(). This allows the
+ * compiler to vectorize the loops. The update of one sensor is an inline
+ * function, used by separate loops with and without magnetometer.
+ */
+
+bool QuaternionFusion_init(QuaternionFusion* f, size_t count, double gain, double integralGain)
+{
+    assert(f != NULL);
+    *f = (QuaternionFusion){0};
+    f->count = count;
+
+    bool ok = true;
+    ok &= (f->orientation.w = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (f->gain = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (f->integralGain = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    for (int k = 0; k < 3; k++) {
+        ok &= (f->orientation.v[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+        ok &= (f->integralError[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    }
+    if (!ok) {
+        QuaternionFusion_free(f);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        f->orientation.w[i] = 1;
+        f->gain[i] = gain;
+        f->integralGain[i] = integralGain;
+    }
+    return true;
+}
+
+void QuaternionFusion_free(QuaternionFusion* f)
+{
+    assert(f != NULL);
+    free(f->orientation.w);
+    free(f->gain);
+    free(f->integralGain);
+    for (int k = 0; k < 3; k++) {
+        free(f->orientation.v[k]);
+        free(f->integralError[k]);
+    }
+    *f = (QuaternionFusion){0};
+}
+
+/**
+ * Normalizes a 3D vector in place and returns 1, or returns 0 for a zero vector.
+ */
+static inline double normalizeReading(double* x, double* y, double* z)
+{
+    double norm2 = (*x)*(*x) + (*y)*(*y) + (*z)*(*z);
+    double s = Quaternion_fastInverseSqrt(norm2);
+    *x *= s;
+    *y *= s;
+    *z *= s;
+    return Quaternion_select(norm2 > 0, 1.0, 0.0);
+}
+
+/**
+ * Rotates the magnetometer reading into the earth frame and returns the
+ * horizontal (bx) and vertical (bz) component of the earth's field.
+ */
+static inline void earthField(double q0, double q1, double q2, double q3,
+    double mx, double my, double mz, double* bx, double* bz)
+{
+    double hx = mx*(q0*q0 + q1*q1 - q2*q2 - q3*q3) + 2*my*(q1*q2 - q0*q3) + 2*mz*(q1*q3 + q0*q2);
+    double hy = 2*mx*(q1*q2 + q0*q3) + my*(q0*q0 - q1*q1 + q2*q2 - q3*q3) + 2*mz*(q2*q3 - q0*q1);
+    double hz = 2*mx*(q1*q3 - q0*q2) + 2*my*(q2*q3 + q0*q1) + mz*(q0*q0 - q1*q1 - q2*q2 + q3*q3);
+    *bx = sqrt(hx*hx + hy*hy);
+    *bz = hz;
+}
+
+/**
+ * One Madgwick update of the orientation q. Without magnetometer (mag NULL),
+ * the branch disappears when inlined.
+ */
+static inline void madgwick(double q[4], const double gyro[3], const double accel[3], const double mag[3],
+    double gain, double dt)
+{
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    double gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    double ax = accel[0], ay = accel[1], az = accel[2];
+    double aValid = normalizeReading(&ax, &ay, &az);
+
+    // Rate of change from the gyroscope: 0.5 * q * (0, gyro)
+    double qDot0 = 0.5 * (-q1*gx - q2*gy - q3*gz);
+    double qDot1 = 0.5 * ( q0*gx + q2*gz - q3*gy);
+    double qDot2 = 0.5 * ( q0*gy - q1*gz + q3*gx);
+    double qDot3 = 0.5 * ( q0*gz + q1*gy - q2*gx);
+
+    // Objective function: gravity in sensor frame minus the measurement
+    double f0 = 2*(q1*q3 - q0*q2) - ax;
+    double f1 = 2*(q0*q1 + q2*q3) - ay;
+    double f2 = 2*(0.5 - q1*q1 - q2*q2) - az;
+
+    // Gradient of the objective function: J^T * f
+    double s0 = -2*q2*f0 + 2*q1*f1;
+    double s1 =  2*q3*f0 + 2*q0*f1 - 4*q1*f2;
+    double s2 = -2*q0*f0 + 2*q3*f1 - 4*q2*f2;
+    double s3 =  2*q1*f0 + 2*q2*f1;
+
+    if (mag != NULL) {
+        double mx = mag[0], my = mag[1], mz = mag[2];
+        double mValid = normalizeReading(&mx, &my, &mz);
+        double bx, bz;
+        earthField(q0, q1, q2, q3, mx, my, mz, &bx, &bz);
+
+        // Objective function: earth field in sensor frame minus the measurement
+        double b0 = 2*bx*(0.5 - q2*q2 - q3*q3) + 2*bz*(q1*q3 - q0*q2) - mx;
+        double b1 = 2*bx*(q1*q2 - q0*q3) + 2*bz*(q0*q1 + q2*q3) - my;
+        double b2 = 2*bx*(q0*q2 + q1*q3) + 2*bz*(0.5 - q1*q1 - q2*q2) - mz;
+
+        s0 += mValid * (-2*bz*q2*b0 + (-2*bx*q3 + 2*bz*q1)*b1 + 2*bx*q2*b2);
+        s1 += mValid * ( 2*bz*q3*b0 + ( 2*bx*q2 + 2*bz*q0)*b1 + (2*bx*q3 - 4*bz*q1)*b2);
+        s2 += mValid * ((-4*bx*q2 - 2*bz*q0)*b0 + (2*bx*q1 + 2*bz*q3)*b1 + (2*bx*q0 - 4*bz*q2)*b2);
+        s3 += mValid * ((-4*bx*q3 + 2*bz*q1)*b0 + (-2*bx*q0 + 2*bz*q2)*b1 + 2*bx*q1*b2);
+    }
+
+    // Step along the normalized gradient (skipped without accelerometer)
+    double step = aValid * gain * Quaternion_fastInverseSqrt(s0*s0 + s1*s1 + s2*s2 + s3*s3);
+    q0 += (qDot0 - step * s0) * dt;
+    q1 += (qDot1 - step * s1) * dt;
+    q2 += (qDot2 - step * s2) * dt;
+    q3 += (qDot3 - step * s3) * dt;
+
+    double norm = Quaternion_fastInverseSqrt(q0*q0 + q1*q1 + q2*q2 + q3*q3);
+    q[0] = q0 * norm;
+    q[1] = q1 * norm;
+    q[2] = q2 * norm;
+    q[3] = q3 * norm;
+}
+
+void QuaternionFusion_updateMadgwick(QuaternionFusion* f, double* gyro[3], double* accel[3], double* mag[3], double dt)
+{
+    assert(f != NULL);
+    double* qw = f->orientation.w;
+    double* qx = f->orientation.v[0];
+    double* qy = f->orientation.v[1];
+    double* qz = f->orientation.v[2];
+    const double* gain = f->gain;
+    const double* gyroX = gyro[0];
+    const double* gyroY = gyro[1];
+    const double* gyroZ = gyro[2];
+    const double* accelX = accel[0];
+    const double* accelY = accel[1];
+    const double* accelZ = accel[2];
+    size_t count = f->count;
+
+    // One loop with and one without magnetometer, neither has a branch
+    if (mag != NULL) {
+        const double* magX = mag[0];
+        const double* magY = mag[1];
+        const double* magZ = mag[2];
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = 0; i < count; i++) {
+            double q[4] = {qw[i], qx[i], qy[i], qz[i]};
+            double g[3] = {gyroX[i], gyroY[i], gyroZ[i]};
+            double a[3] = {accelX[i], accelY[i], accelZ[i]};
+            double m[3] = {magX[i], magY[i], magZ[i]};
+            madgwick(q, g, a, m, gain[i], dt);
+            qw[i] = q[0];
+            qx[i] = q[1];
+            qy[i] = q[2];
+            qz[i] = q[3];
+        }
+    } else {
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = 0; i < count; i++) {
+            double q[4] = {qw[i], qx[i], qy[i], qz[i]};
+            double g[3] = {gyroX[i], gyroY[i], gyroZ[i]};
+            double a[3] = {accelX[i], accelY[i], accelZ[i]};
+            madgwick(q, g, a, NULL, gain[i], dt);
+            qw[i] = q[0];
+            qx[i] = q[1];
+            qy[i] = q[2];
+            qz[i] = q[3];
+        }
+    }
+}
+
+/**
+ * One Mahony update of the orientation q and the integrated error e.
+ * Without magnetometer (mag NULL), the branch disappears when inlined.
+ */
+static inline void mahony(double q[4], double e[3], const double gyro[3], const double accel[3],
+    const double mag[3], double gain, double integralGain, double dt)
+{
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    double gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    double ax = accel[0], ay = accel[1], az = accel[2];
+    double aValid = normalizeReading(&ax, &ay, &az);
+
+    // Estimated gravity direction in sensor frame
+    double vx = 2*(q1*q3 - q0*q2);
+    double vy = 2*(q0*q1 + q2*q3);
+    double vz = q0*q0 - q1*q1 - q2*q2 + q3*q3;
+
+    // Error between measured and estimated direction
+    double ex = ay*vz - az*vy;
+    double ey = az*vx - ax*vz;
+    double ez = ax*vy - ay*vx;
+
+    if (mag != NULL) {
+        double mx = mag[0], my = mag[1], mz = mag[2];
+        double mValid = normalizeReading(&mx, &my, &mz);
+        double bx, bz;
+        earthField(q0, q1, q2, q3, mx, my, mz, &bx, &bz);
+
+        // Estimated earth field direction in sensor frame
+        double wx = bx*(q0*q0 + q1*q1 - q2*q2 - q3*q3) + 2*bz*(q1*q3 - q0*q2);
+        double wy = 2*bx*(q1*q2 - q0*q3) + 2*bz*(q0*q1 + q2*q3);
+        double wz = 2*bx*(q0*q2 + q1*q3) + bz*(q0*q0 - q1*q1 - q2*q2 + q3*q3);
+
+        ex += mValid * (my*wz - mz*wy);
+        ey += mValid * (mz*wx - mx*wz);
+        ez += mValid * (mx*wy - my*wx);
+    }
+    ex *= aValid;
+    ey *= aValid;
+    ez *= aValid;
+
+    // Proportional and integral feedback
+    double ki = integralGain * dt;
+    e[0] += ki * ex;
+    e[1] += ki * ey;
+    e[2] += ki * ez;
+    gx += gain * ex + e[0];
+    gy += gain * ey + e[1];
+    gz += gain * ez + e[2];
+
+    // Integrate rate of change: 0.5 * q * (0, gyro)
+    double h = 0.5 * dt;
+    double r0 = q0 + h * (-q1*gx - q2*gy - q3*gz);
+    double r1 = q1 + h * ( q0*gx + q2*gz - q3*gy);
+    double r2 = q2 + h * ( q0*gy - q1*gz + q3*gx);
+    double r3 = q3 + h * ( q0*gz + q1*gy - q2*gx);
+
+    double norm = Quaternion_fastInverseSqrt(r0*r0 + r1*r1 + r2*r2 + r3*r3);
+    q[0] = r0 * norm;
+    q[1] = r1 * norm;
+    q[2] = r2 * norm;
+    q[3] = r3 * norm;
+}
+
+void QuaternionFusion_updateMahony(QuaternionFusion* f, double* gyro[3], double* accel[3], double* mag[3], double dt)
+{
+    assert(f != NULL);
+    double* qw = f->orientation.w;
+    double* qx = f->orientation.v[0];
+    double* qy = f->orientation.v[1];
+    double* qz = f->orientation.v[2];
+    double* ix = f->integralError[0];
+    double* iy = f->integralError[1];
+    double* iz = f->integralError[2];
+    const double* gain = f->gain;
+    const double* integralGain = f->integralGain;
+    const double* gyroX = gyro[0];
+    const double* gyroY = gyro[1];
+    const double* gyroZ = gyro[2];
+    const double* accelX = accel[0];
+    const double* accelY = accel[1];
+    const double* accelZ = accel[2];
+    size_t count = f->count;
+
+    // One loop with and one without magnetometer, neither has a branch
+    if (mag != NULL) {
+        const double* magX = mag[0];
+        const double* magY = mag[1];
+        const double* magZ = mag[2];
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = 0; i < count; i++) {
+            double q[4] = {qw[i], qx[i], qy[i], qz[i]};
+            double e[3] = {ix[i], iy[i], iz[i]};
+            double g[3] = {gyroX[i], gyroY[i], gyroZ[i]};
+            double a[3] = {accelX[i], accelY[i], accelZ[i]};
+            double m[3] = {magX[i], magY[i], magZ[i]};
+            mahony(q, e, g, a, m, gain[i], integralGain[i], dt);
+            qw[i] = q[0];
+            qx[i] = q[1];
+            qy[i] = q[2];
+            qz[i] = q[3];
+            ix[i] = e[0];
+            iy[i] = e[1];
+            iz[i] = e[2];
+        }
+    } else {
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = 0; i < count; i++) {
+            double q[4] = {qw[i], qx[i], qy[i], qz[i]};
+            double e[3] = {ix[i], iy[i], iz[i]};
+            double g[3] = {gyroX[i], gyroY[i], gyroZ[i]};
+            double a[3] = {accelX[i], accelY[i], accelZ[i]};
+            mahony(q, e, g, a, NULL, gain[i], integralGain[i], dt);
+            qw[i] = q[0];
+            qx[i] = q[1];
+            qy[i] = q[2];
+            qz[i] = q[3];
+            ix[i] = e[0];
+            iy[i] = e[1];
+            iz[i] = e[2];
+        }
+    }
+}
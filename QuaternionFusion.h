@@ -0,0 +1,68 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionFusion.h
+ * @brief   Madgwick and Mahony orientation filters for many sensors at once
+ * @date    2026-10-19
+ */
+#pragma once
+#include "Quaternion.h"
+
+/**
+ * State of orientation filters for many IMUs, stored as structure of arrays.
+ *
+ * Sensor readings are passed as three arrays (x, y, z) with one element per
+ * sensor. Gyroscope rates are in radians per second; accelerometer and
+ * magnetometer readings may have any unit, as they are normalized. Sensors
+ * with an all-zero accelerometer or magnetometer reading skip that correction.
+ */
+typedef struct QuaternionFusion {
+    size_t count;                   /**< Number of sensors */
+    QuaternionArray orientation;    /**< Sensor orientation relative to the earth frame */
+    double* gain;                   /**< Madgwick: beta, Mahony: proportional gain */
+    double* integralGain;           /**< Mahony: integral gain (unused by Madgwick) */
+    double* integralError[3];       /**< Mahony: integrated error (unused by Madgwick) */
+} QuaternionFusion;
+
+/**
+ * Allocates filters for count sensors, all starting with identity orientation.
+ * The gains are set to the given values and can be changed per sensor later.
+ * @return
+ *      False if allocation failed.
+ */
+bool QuaternionFusion_init(QuaternionFusion* f, size_t count, double gain, double integralGain);
+
+/**
+ * Frees all memory of the filters.
+ */
+void QuaternionFusion_free(QuaternionFusion* f);
+
+/**
+ * Advances all filters by one sample using Madgwick's gradient descent filter.
+ * @param mag
+ *      Magnetometer readings or NULL to only use gyroscope and accelerometer.
+ * @param dt
+ *      Time since the last sample in seconds.
+ */
+void QuaternionFusion_updateMadgwick(QuaternionFusion* f, double* gyro[3], double* accel[3], double* mag[3], double dt);
+
+/**
+ * Advances all filters by one sample using Mahony's complementary filter.
+ * @param mag
+ *      Magnetometer readings or NULL to only use gyroscope and accelerometer.
+ * @param dt
+ *      Time since the last sample in seconds.
+ */
+void QuaternionFusion_updateMahony(QuaternionFusion* f, double* gyro[3], double* accel[3], double* mag[3], double dt);
@@ -0,0 +1,220 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionHierarchy.c
+ * @brief   Transform hierarchy that only updates changed subtrees
+ * @date    2026-10-19
+ */
+#include "QuaternionHierarchy.h"
+#include <stdlib.h>
+#include <assert.h>
+
+bool QuaternionHierarchy_init(QuaternionHierarchy* h, const int32_t* parents, size_t count, bool translations)
+{
+    assert(h != NULL);
+    assert(count < INT32_MAX);
+    *h = (QuaternionHierarchy){0};
+    h->count = count;
+
+    bool ok = true;
+    ok &= (h->parent = Quaternion_allocateArray(count, sizeof(int32_t))) != NULL;
+    ok &= (h->subtreeSize = Quaternion_allocateArray(count, sizeof(uint32_t))) != NULL;
+    ok &= (h->isDirty = Quaternion_allocateArray(count, sizeof(bool))) != NULL;
+    ok &= (h->dirty = Quaternion_allocateArray(count, sizeof(uint32_t))) != NULL;
+    ok &= (h->local.w = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (h->world.w = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    for (int k = 0; k < 3; k++) {
+        ok &= (h->local.v[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+        ok &= (h->world.v[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+        if (translations) {
+            ok &= (h->localTranslation[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+            ok &= (h->worldTranslation[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+        }
+    }
+    if (!ok) {
+        QuaternionHierarchy_free(h);
+        return false;
+    }
+
+    // Subtree sizes are accumulated from the leaves towards the roots
+    for (size_t i = 0; i < count; i++) {
+        h->parent[i] = parents[i];
+        h->subtreeSize[i] = 1;
+        h->local.w[i] = 1;
+        h->world.w[i] = 1;
+    }
+    for (size_t i = count; i-- > 0;) {
+        int32_t p = parents[i];
+        if (p >= (int32_t)i || p < -1) {
+            QuaternionHierarchy_free(h);
+            return false;
+        }
+        if (p >= 0)
+            h->subtreeSize[p] += h->subtreeSize[i];
+    }
+
+    // Depth-first order: each child starts right after its parent or
+    // right after the subtree of its previous sibling
+    for (size_t i = 0; i < count; i++) {
+        int32_t p = parents[i];
+        if (p >= 0 && i + h->subtreeSize[i] > (size_t)p + h->subtreeSize[p]) {
+            QuaternionHierarchy_free(h);
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuaternionHierarchy_free(QuaternionHierarchy* h)
+{
+    assert(h != NULL);
+    free(h->parent);
+    free(h->subtreeSize);
+    free(h->isDirty);
+    free(h->dirty);
+    free(h->local.w);
+    free(h->world.w);
+    for (int k = 0; k < 3; k++) {
+        free(h->local.v[k]);
+        free(h->world.v[k]);
+        free(h->localTranslation[k]);
+        free(h->worldTranslation[k]);
+    }
+    *h = (QuaternionHierarchy){0};
+}
+
+void QuaternionHierarchy_markDirty(QuaternionHierarchy* h, size_t node)
+{
+    assert(node < h->count);
+    if (!h->isDirty[node]) {
+        h->isDirty[node] = true;
+        h->dirty[h->dirtyCount++] = (uint32_t)node;
+    }
+}
+
+void QuaternionHierarchy_setLocalRotation(QuaternionHierarchy* h, size_t node, Quaternion* q)
+{
+    assert(node < h->count);
+    Quaternion_store(q, &h->local, node);
+    QuaternionHierarchy_markDirty(h, node);
+}
+
+void QuaternionHierarchy_setLocalRotations(QuaternionHierarchy* h, const uint32_t* nodes, Quaternion* rotations, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        QuaternionHierarchy_setLocalRotation(h, nodes[i], &rotations[i]);
+}
+
+void QuaternionHierarchy_setLocalTranslation(QuaternionHierarchy* h, size_t node, double t[3])
+{
+    assert(node < h->count);
+    assert(h->localTranslation[0] != NULL);
+    h->localTranslation[0][node] = t[0];
+    h->localTranslation[1][node] = t[1];
+    h->localTranslation[2][node] = t[2];
+    QuaternionHierarchy_markDirty(h, node);
+}
+
+static int compareNodes(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void updateRange(QuaternionHierarchy* h, size_t begin, size_t end)
+{
+    const int32_t* parent = h->parent;
+    const double* lw = h->local.w;
+    const double* lx = h->local.v[0];
+    const double* ly = h->local.v[1];
+    const double* lz = h->local.v[2];
+    double* ww = h->world.w;
+    double* wx = h->world.v[0];
+    double* wy = h->world.v[1];
+    double* wz = h->world.v[2];
+    bool translations = h->localTranslation[0] != NULL;
+
+    // Parents come first, so they are always up to date when a child is reached
+    for (size_t i = begin; i < end; i++) {
+        int32_t p = parent[i];
+        if (p < 0) {
+            ww[i] = lw[i];
+            wx[i] = lx[i];
+            wy[i] = ly[i];
+            wz[i] = lz[i];
+            if (translations) {
+                for (int k = 0; k < 3; k++)
+                    h->worldTranslation[k][i] = h->localTranslation[k][i];
+            }
+            continue;
+        }
+
+        // world[i] = world[p] * local[i], see Quaternion_multiply
+        double aw = ww[p], ax = wx[p], ay = wy[p], az = wz[p];
+        double bw = lw[i], bx = lx[i], by = ly[i], bz = lz[i];
+        ww[i] = aw*bw - ax*bx - ay*by - az*bz;
+        wx[i] = ax*bw + aw*bx + ay*bz - az*by;
+        wy[i] = aw*by - ax*bz + ay*bw + az*bx;
+        wz[i] = aw*bz + ax*by - ay*bx + az*bw;
+
+        if (translations) {
+            // worldTranslation[i] = worldTranslation[p] + world[p] applied to localTranslation[i]
+            Quaternion q;
+            double t[3] = {h->localTranslation[0][i], h->localTranslation[1][i], h->localTranslation[2][i]};
+            Quaternion_set(aw, ax, ay, az, &q);
+            Quaternion_rotate(&q, t, t);
+            for (int k = 0; k < 3; k++)
+                h->worldTranslation[k][i] = h->worldTranslation[k][p] + t[k];
+        }
+    }
+}
+
+size_t QuaternionHierarchy_update(QuaternionHierarchy* h)
+{
+    assert(h != NULL);
+    // Sorted dirty nodes visit every dirty subtree once: a node that lies
+    // within an earlier subtree is updated together with that subtree
+    qsort(h->dirty, h->dirtyCount, sizeof(uint32_t), compareNodes);
+
+    size_t updated = 0;
+    size_t end = 0;
+    for (size_t k = 0; k < h->dirtyCount; k++) {
+        size_t node = h->dirty[k];
+        h->isDirty[node] = false;
+        if (node < end)
+            continue;
+        end = node + h->subtreeSize[node];
+        updateRange(h, node, end);
+        updated += end - node;
+    }
+    h->dirtyCount = 0;
+    return updated;
+}
+
+void QuaternionHierarchy_getWorldRotation(QuaternionHierarchy* h, size_t node, Quaternion* output)
+{
+    assert(node < h->count);
+    Quaternion_load(&h->world, node, output);
+}
+
+void QuaternionHierarchy_getWorldTranslation(QuaternionHierarchy* h, size_t node, double output[3])
+{
+    assert(node < h->count);
+    assert(h->worldTranslation[0] != NULL);
+    output[0] = h->worldTranslation[0][node];
+    output[1] = h->worldTranslation[1][node];
+    output[2] = h->worldTranslation[2][node];
+}
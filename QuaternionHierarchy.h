@@ -0,0 +1,95 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionHierarchy.h
+ * @brief   Transform hierarchy that only updates changed subtrees
+ * @date    2026-10-19
+ */
+#pragma once
+#include "Quaternion.h"
+
+/**
+ * Flat transform hierarchy (e.g., a scene graph or a kinematic chain).
+ *
+ * Nodes are stored in depth-first order: every parent comes before its
+ * children and every subtree occupies a contiguous index range. Changing a
+ * local transform marks the node as dirty. QuaternionHierarchy_update() then
+ * recomputes the world transforms of the dirty subtrees in one linear pass.
+ */
+typedef struct QuaternionHierarchy {
+    size_t count;                   /**< Number of nodes */
+    int32_t* parent;                /**< Parent index per node, -1 for roots */
+    uint32_t* subtreeSize;          /**< Nodes in the subtree, including the node itself */
+    QuaternionArray local;          /**< Rotation relative to the parent */
+    QuaternionArray world;          /**< Rotation relative to the root frame */
+    double* localTranslation[3];    /**< Translation relative to the parent (NULL if disabled) */
+    double* worldTranslation[3];    /**< Translation relative to the root frame (NULL if disabled) */
+    bool* isDirty;                  /**< Whether a node is in the dirty list */
+    uint32_t* dirty;                /**< Nodes changed since the last update */
+    size_t dirtyCount;              /**< Number of entries in dirty */
+} QuaternionHierarchy;
+
+/**
+ * Allocates a hierarchy. All local and world rotations are set to identity.
+ * @param parents
+ *      Parent index per node (-1 for roots) in depth-first order.
+ * @param translations
+ *      Whether translations are stored and propagated along with rotations.
+ * @return
+ *      False if the parents are not in depth-first order or allocation failed.
+ */
+bool QuaternionHierarchy_init(QuaternionHierarchy* h, const int32_t* parents, size_t count, bool translations);
+
+/**
+ * Frees all memory of a hierarchy.
+ */
+void QuaternionHierarchy_free(QuaternionHierarchy* h);
+
+/**
+ * Marks a node as changed, e.g., after writing h->local directly.
+ */
+void QuaternionHierarchy_markDirty(QuaternionHierarchy* h, size_t node);
+
+/**
+ * Sets the local rotation of a node.
+ */
+void QuaternionHierarchy_setLocalRotation(QuaternionHierarchy* h, size_t node, Quaternion* q);
+
+/**
+ * Sets the local rotations of many nodes: local[nodes[i]] = rotations[i]
+ */
+void QuaternionHierarchy_setLocalRotations(QuaternionHierarchy* h, const uint32_t* nodes, Quaternion* rotations, size_t count);
+
+/**
+ * Sets the local translation of a node. Requires translations to be enabled.
+ */
+void QuaternionHierarchy_setLocalTranslation(QuaternionHierarchy* h, size_t node, double t[3]);
+
+/**
+ * Recomputes the world transforms of all dirty subtrees.
+ * @return
+ *      The number of recomputed nodes.
+ */
+size_t QuaternionHierarchy_update(QuaternionHierarchy* h);
+
+/**
+ * Gets the world rotation of a node (valid after QuaternionHierarchy_update).
+ */
+void QuaternionHierarchy_getWorldRotation(QuaternionHierarchy* h, size_t node, Quaternion* output);
+
+/**
+ * Gets the world translation of a node (valid after QuaternionHierarchy_update).
+ */
+void QuaternionHierarchy_getWorldTranslation(QuaternionHierarchy* h, size_t node, double output[3]);
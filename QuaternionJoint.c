@@ -0,0 +1,193 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+/**
+ * @file    QuaternionJoint.c
+ * @brief   Swing-twist limits for many joints at once
+ * @date    2026-10-19
+ */
+#include "QuaternionJoint.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <float.h>
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+
+// Joints per call of Quaternion_swingTwistArray(), small enough for the stack
+#define BLOCK_SIZE 256
+
+/*
+ * With the twist normalized to w >= 0, it is (cos(a), sin(a) * axis) for
+ * half the twist angle a in [-pi/2, pi/2]. With the swing negated to w >= 0,
+ * it is (cos(b), sin(b) * swing axis) for half the swing angle b in
+ * [0, pi/2]. A limit l is exceeded if sin(a - l) = sin(a) cos(l) -
+ * cos(a) sin(l) has the wrong sign, which needs no trigonometric functions
+ * with the cached half-angle values. Unlike comparing sin(a) with sin(l) or
+ * cos(b) with cos(l), this stays accurate where sine or cosine is flat,
+ * i.e., near twists of 180 degrees and tiny cones.
+ * The clamp decomposes blocks of joints with Quaternion_swingTwistArray()
+ * and clamps them in a loop without data-dependent branches, so the
+ * compiler can vectorize both.
+ */
+
+bool QuaternionJointLimits_init(QuaternionJointLimits* limits, size_t count)
+{
+    assert(limits != NULL);
+    *limits = (QuaternionJointLimits){0};
+    limits->count = count;
+
+    bool ok = true;
+    for (int k = 0; k < 3; k++)
+        ok &= (limits->axis[k] = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->cosHalfCone = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->sinHalfCone = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->cosHalfTwistMin = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->sinHalfTwistMin = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->cosHalfTwistMax = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    ok &= (limits->sinHalfTwistMax = Quaternion_allocateArray(count, sizeof(double))) != NULL;
+    if (!ok) {
+        QuaternionJointLimits_free(limits);
+        return false;
+    }
+
+    // Half of +-180 degrees: cos = 0, sin = +-1
+    for (size_t i = 0; i < count; i++) {
+        limits->axis[0][i] = 1;
+        limits->axis[1][i] = 0;
+        limits->axis[2][i] = 0;
+        limits->cosHalfCone[i] = 0;
+        limits->sinHalfCone[i] = 1;
+        limits->cosHalfTwistMin[i] = 0;
+        limits->sinHalfTwistMin[i] = -1;
+        limits->cosHalfTwistMax[i] = 0;
+        limits->sinHalfTwistMax[i] = 1;
+    }
+    return true;
+}
+
+void QuaternionJointLimits_free(QuaternionJointLimits* limits)
+{
+    assert(limits != NULL);
+    for (int k = 0; k < 3; k++)
+        free(limits->axis[k]);
+    free(limits->cosHalfCone);
+    free(limits->sinHalfCone);
+    free(limits->cosHalfTwistMin);
+    free(limits->sinHalfTwistMin);
+    free(limits->cosHalfTwistMax);
+    free(limits->sinHalfTwistMax);
+    *limits = (QuaternionJointLimits){0};
+}
+
+void QuaternionJointLimits_set(QuaternionJointLimits* limits, size_t joint, double axis[3],
+    double cone, double twistMin, double twistMax)
+{
+    assert(limits != NULL);
+    assert(joint < limits->count);
+    assert(cone >= 0 && cone <= M_PI);
+    assert(twistMin >= -M_PI && twistMin <= twistMax && twistMax <= M_PI);
+
+    double len = sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+    assert(len > 0);
+    for (int k = 0; k < 3; k++)
+        limits->axis[k][joint] = axis[k] / len;
+    limits->cosHalfCone[joint] = cos(cone / 2);
+    limits->sinHalfCone[joint] = sin(cone / 2);
+    limits->cosHalfTwistMin[joint] = cos(twistMin / 2);
+    limits->sinHalfTwistMin[joint] = sin(twistMin / 2);
+    limits->cosHalfTwistMax[joint] = cos(twistMax / 2);
+    limits->sinHalfTwistMax[joint] = sin(twistMax / 2);
+}
+
+void QuaternionJointLimits_clamp(QuaternionJointLimits* limits, QuaternionArray* rotations, QuaternionArray* output)
+{
+    assert(limits != NULL);
+    assert(output != NULL);
+    double swingW[BLOCK_SIZE], swingX[BLOCK_SIZE], swingY[BLOCK_SIZE], swingZ[BLOCK_SIZE];
+    double twistW[BLOCK_SIZE], twistX[BLOCK_SIZE], twistY[BLOCK_SIZE], twistZ[BLOCK_SIZE];
+    QuaternionArray swing = {swingW, {swingX, swingY, swingZ}};
+    QuaternionArray twist = {twistW, {twistX, twistY, twistZ}};
+
+    for (size_t begin = 0; begin < limits->count; begin += BLOCK_SIZE) {
+        size_t count = (limits->count - begin < BLOCK_SIZE) ? limits->count - begin : BLOCK_SIZE;
+        QuaternionArray q = {rotations->w + begin,
+            {rotations->v[0] + begin, rotations->v[1] + begin, rotations->v[2] + begin}};
+        double* axis[3] = {limits->axis[0] + begin, limits->axis[1] + begin, limits->axis[2] + begin};
+        Quaternion_swingTwistArray(&q, axis, count, &swing, &twist);
+
+        const double* qw = q.w;
+        const double* qx = q.v[0];
+        const double* qy = q.v[1];
+        const double* qz = q.v[2];
+        const double* ax = axis[0];
+        const double* ay = axis[1];
+        const double* az = axis[2];
+        const double* cosCone = limits->cosHalfCone + begin;
+        const double* sinCone = limits->sinHalfCone + begin;
+        const double* cosMin = limits->cosHalfTwistMin + begin;
+        const double* sinMin = limits->sinHalfTwistMin + begin;
+        const double* cosMax = limits->cosHalfTwistMax + begin;
+        const double* sinMax = limits->sinHalfTwistMax + begin;
+        double* ow = output->w + begin;
+        double* ox = output->v[0] + begin;
+        double* oy = output->v[1] + begin;
+        double* oz = output->v[2] + begin;
+
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = 0; i < count; i++) {
+            double axisX = ax[i], axisY = ay[i], axisZ = az[i];
+
+            // Twist (tw, ts * axis) with tw >= 0
+            double tw = twistW[i];
+            double ts = twistX[i]*axisX + twistY[i]*axisY + twistZ[i]*axisZ;
+
+            // Swing negated to sw >= 0 (the sign is restored below)
+            double swingSign = Quaternion_select(swingW[i] < 0, -1.0, 1.0);
+            double sw = swingW[i] * swingSign;
+            double sx = swingX[i] * swingSign;
+            double sy = swingY[i] * swingSign;
+            double sz = swingZ[i] * swingSign;
+
+            // Twist range: sign of sin(twist / 2 - limit / 2)
+            bool belowMin = ts*cosMin[i] - tw*sinMin[i] < 0;
+            bool aboveMax = ts*cosMax[i] - tw*sinMax[i] > 0;
+            tw = Quaternion_select(belowMin, cosMin[i], Quaternion_select(aboveMax, cosMax[i], tw));
+            ts = Quaternion_select(belowMin, sinMin[i], Quaternion_select(aboveMax, sinMax[i], ts));
+
+            // Cone: keep the swing axis, reduce the swing angle
+            double len = sqrt(sx*sx + sy*sy + sz*sz);
+            bool outside = len*cosCone[i] - sw*sinCone[i] > 0;
+            double scale = Quaternion_select(outside, sinCone[i] / Quaternion_select(len > DBL_MIN, len, DBL_MIN), 1.0);
+            sw = Quaternion_select(outside, cosCone[i], sw);
+            sx *= scale;
+            sy *= scale;
+            sz *= scale;
+
+            // Recompose swing * twist with the sign of the input
+            double tx = ts * axisX, ty = ts * axisY, tz = ts * axisZ;
+            double rw = sw*tw - sx*tx - sy*ty - sz*tz;
+            double rx = sx*tw + sw*tx + sy*tz - sz*ty;
+            double ry = sw*ty - sx*tz + sy*tw + sz*tx;
+            double rz = sw*tz + sx*ty - sy*tx + sz*tw;
+            double sign = Quaternion_select(rw*qw[i] + rx*qx[i] + ry*qy[i] + rz*qz[i] < 0, -1.0, 1.0);
+            ow[i] = rw * sign;
+            ox[i] = rx * sign;
+            oy[i] = ry * sign;
+            oz[i] = rz * sign;
+        }
+    }
+}
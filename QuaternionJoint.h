@@ -0,0 +1,81 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+
+/**
+ * @file    QuaternionJoint.h
+ * @brief   Swing-twist limits for many joints at once
+ * @date    2026-10-19
+ */
+#pragma once
+#include "Quaternion.h"
+
+/**
+ * Joint limits for many joints, stored as structure of arrays.
+ *
+ * Each joint rotation is split into a twist around the joint axis and a swing
+ * of that axis (see Quaternion_swingTwist()). The swing angle is limited by a
+ * cone and the twist angle by a range. The limits are stored as cosine and
+ * sine of the half angles, which are the components of the swing and twist
+ * quaternions, so clamping needs no trigonometric functions.
+ * Use QuaternionJointLimits_set() to change the limits of a joint.
+ */
+typedef struct QuaternionJointLimits {
+    size_t count;                   /**< Number of joints */
+    double* axis[3];                /**< Twist axis (bone direction) in the parent frame, normalized */
+    double* cosHalfCone;            /**< Cone: maximum swing angle */
+    double* sinHalfCone;
+    double* cosHalfTwistMin;        /**< Minimum twist angle */
+    double* sinHalfTwistMin;
+    double* cosHalfTwistMax;        /**< Maximum twist angle */
+    double* sinHalfTwistMax;
+} QuaternionJointLimits;
+
+/**
+ * Allocates limits for count joints. All joints start with the X-axis as
+ * twist axis and without limits.
+ * @return
+ *      False if allocation failed.
+ */
+bool QuaternionJointLimits_init(QuaternionJointLimits* limits, size_t count);
+
+/**
+ * Frees all memory of the limits.
+ */
+void QuaternionJointLimits_free(QuaternionJointLimits* limits);
+
+/**
+ * Sets the limits of one joint. Angles are in radians.
+ * @param axis
+ *      Twist axis, does not need to be normalized.
+ * @param cone
+ *      Maximum swing angle within [0, pi], pi for no limit.
+ * @param twistMin, twistMax
+ *      Twist range within [-pi, pi], with twistMin <= twistMax.
+ */
+void QuaternionJointLimits_set(QuaternionJointLimits* limits, size_t joint, double axis[3],
+    double cone, double twistMin, double twistMax);
+
+/**
+ * Clamps the rotation of every joint to its limits. Swing and twist are
+ * clamped separately, so a rotation outside the cone keeps its twist and
+ * vice versa. Rotations within the limits are kept up to rounding. The result
+ * has the same sign as the input (non-negative dot product).
+ * @param rotations
+ *      Joint rotations relative to the parent, e.g., QuaternionHierarchy local
+ *      rotations. Must be normalized.
+ * @param output
+ *      Clamped rotations, may be the same array as rotations.
+ */
+void QuaternionJointLimits_clamp(QuaternionJointLimits* limits, QuaternionArray* rotations, QuaternionArray* output);
@@ -0,0 +1,343 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionPipeline.c
+ * @brief   Multi-threaded pipeline of stages connected by lock-free queues
+ * @date    2026-10-19
+ */
+// clock_gettime() and CLOCK_MONOTONIC are POSIX, not ISO C
+#define _POSIX_C_SOURCE 199309L
+#include "QuaternionPipeline.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec ts;
+#if defined(TIME_MONOTONIC)
+    timespec_get(&ts, TIME_MONOTONIC);
+#elif defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Clamped to zero, in case the clock is not monotonic and steps backwards
+static uint64_t elapsed(uint64_t from, uint64_t to)
+{
+    return (to > from) ? to - from : 0;
+}
+
+bool QuaternionBatch_init(QuaternionBatch* batch, size_t capacity)
+{
+    assert(batch != NULL);
+    *batch = (QuaternionBatch){0};
+    batch->capacity = capacity;
+
+    bool ok = true;
+    ok &= (batch->q.w = Quaternion_allocateArray(capacity, sizeof(double))) != NULL;
+    for (int k = 0; k < 3; k++) {
+        ok &= (batch->q.v[k] = Quaternion_allocateArray(capacity, sizeof(double))) != NULL;
+        ok &= (batch->v[k] = Quaternion_allocateArray(capacity, sizeof(double))) != NULL;
+    }
+    if (!ok) {
+        QuaternionBatch_free(batch);
+        return false;
+    }
+    return true;
+}
+
+void QuaternionBatch_free(QuaternionBatch* batch)
+{
+    assert(batch != NULL);
+    free(batch->q.w);
+    for (int k = 0; k < 3; k++) {
+        free(batch->q.v[k]);
+        free(batch->v[k]);
+    }
+    *batch = (QuaternionBatch){0};
+}
+
+
+/*
+ * Bounded queue by Dmitry Vyukov: every cell carries a sequence number that
+ * tells whether it is ready to be written (sequence == position) or to be
+ * read (sequence == position + 1). The release store of the sequence
+ * publishes the batch pointer to the acquiring thread on the other side.
+ */
+
+bool QuaternionQueue_init(QuaternionQueue* queue, size_t capacity, bool multiProducer, bool multiConsumer)
+{
+    assert(queue != NULL);
+    size_t n = 2;
+    while (n < capacity)
+        n *= 2;
+
+    queue->cells = malloc(n * sizeof(QuaternionQueueCell));
+    if (queue->cells == NULL)
+        return false;
+    queue->mask = n - 1;
+    queue->multiProducer = multiProducer;
+    queue->multiConsumer = multiConsumer;
+    for (size_t i = 0; i < n; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+        queue->cells[i].batch = NULL;
+    }
+    atomic_init(&queue->tail, 0);
+    atomic_init(&queue->head, 0);
+    return true;
+}
+
+void QuaternionQueue_free(QuaternionQueue* queue)
+{
+    assert(queue != NULL);
+    free(queue->cells);
+    queue->cells = NULL;
+}
+
+bool QuaternionQueue_push(QuaternionQueue* queue, QuaternionBatch* batch)
+{
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    QuaternionQueueCell* cell;
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (sequence == pos) {
+            if (!queue->multiProducer) {
+                atomic_store_explicit(&queue->tail, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (sequence < pos) {
+            // The cell still holds the batch from one round earlier
+            return false;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+    cell->batch = batch;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+QuaternionBatch* QuaternionQueue_pop(QuaternionQueue* queue)
+{
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    QuaternionQueueCell* cell;
+    for (;;) {
+        cell = &queue->cells[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        if (sequence == pos + 1) {
+            if (!queue->multiConsumer) {
+                atomic_store_explicit(&queue->head, pos + 1, memory_order_relaxed);
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (sequence < pos + 1) {
+            // The cell has not been written in this round
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+    QuaternionBatch* batch = cell->batch;
+    atomic_store_explicit(&cell->sequence, pos + queue->mask + 1, memory_order_release);
+    return batch;
+}
+
+
+static void recordProcessed(QuaternionStageCounters* c, size_t count, uint64_t start, uint64_t end)
+{
+    atomic_fetch_add_explicit(&c->batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->elements, count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->busyTime, elapsed(start, end), memory_order_relaxed);
+}
+
+static void recordPushed(QuaternionStageCounters* c, uint64_t submitTime, uint64_t end, uint64_t pushed)
+{
+    uint64_t latency = elapsed(submitTime, pushed);
+    atomic_fetch_add_explicit(&c->stallTime, elapsed(end, pushed), memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->latency, latency, memory_order_relaxed);
+
+    uint_least64_t max = atomic_load_explicit(&c->maxLatency, memory_order_relaxed);
+    while (latency > max && !atomic_compare_exchange_weak_explicit(&c->maxLatency, &max, latency,
+            memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static int runWorker(void* arg)
+{
+    QuaternionWorker* worker = arg;
+    QuaternionPipeline* p = worker->pipeline;
+    QuaternionStage* stage = &p->stages[worker->stage];
+    QuaternionStageCounters* counters = &p->counters[worker->stage];
+    QuaternionQueue* input = &p->queues[worker->stage];
+    QuaternionQueue* output = &p->queues[worker->stage + 1];
+
+    for (;;) {
+        QuaternionBatch* batch = QuaternionQueue_pop(input);
+        if (batch == NULL) {
+            if (atomic_load_explicit(&p->stopping, memory_order_relaxed))
+                return 0;
+            thrd_yield();
+            continue;
+        }
+
+        uint64_t start = nanoseconds();
+        stage->function(batch, stage->context);
+        uint64_t end = nanoseconds();
+        // Counted before the push, so a received batch is always included.
+        // Once pushed, the batch belongs to the next stage.
+        recordProcessed(counters, batch->count, start, end);
+        uint64_t submitTime = batch->submitTime;
+        while (!QuaternionQueue_push(output, batch)) {
+            if (atomic_load_explicit(&p->stopping, memory_order_relaxed))
+                return 0;
+            thrd_yield();
+        }
+        recordPushed(counters, submitTime, end, nanoseconds());
+    }
+}
+
+bool QuaternionPipeline_init(QuaternionPipeline* p, const QuaternionStage* stages, size_t stageCount, size_t queueCapacity)
+{
+    assert(p != NULL);
+    assert(stageCount > 0);
+    *p = (QuaternionPipeline){0};
+    atomic_init(&p->stopping, false);
+    p->stageCount = stageCount;
+
+    size_t threads = 0;
+    for (size_t s = 0; s < stageCount; s++) {
+        assert(stages[s].function != NULL);
+        threads += (stages[s].threads > 0) ? stages[s].threads : 1;
+    }
+
+    bool ok = true;
+    ok &= (p->stages = malloc(stageCount * sizeof(QuaternionStage))) != NULL;
+    ok &= (p->counters = calloc(stageCount, sizeof(QuaternionStageCounters))) != NULL;
+    ok &= (p->queues = calloc(stageCount + 1, sizeof(QuaternionQueue))) != NULL;
+    ok &= (p->workers = malloc(threads * sizeof(QuaternionWorker))) != NULL;
+    if (!ok) {
+        QuaternionPipeline_free(p);
+        return false;
+    }
+
+    for (size_t s = 0; s < stageCount; s++) {
+        p->stages[s] = stages[s];
+        if (p->stages[s].threads == 0)
+            p->stages[s].threads = 1;
+        QuaternionStageCounters* c = &p->counters[s];
+        atomic_init(&c->batches, 0);
+        atomic_init(&c->elements, 0);
+        atomic_init(&c->busyTime, 0);
+        atomic_init(&c->stallTime, 0);
+        atomic_init(&c->latency, 0);
+        atomic_init(&c->maxLatency, 0);
+    }
+    for (size_t s = 0; s <= stageCount; s++) {
+        bool multiProducer = s > 0 && p->stages[s - 1].threads > 1;
+        bool multiConsumer = s < stageCount && p->stages[s].threads > 1;
+        if (!QuaternionQueue_init(&p->queues[s], queueCapacity, multiProducer, multiConsumer)) {
+            QuaternionPipeline_free(p);
+            return false;
+        }
+    }
+
+    for (size_t s = 0; s < stageCount; s++) {
+        for (unsigned t = 0; t < p->stages[s].threads; t++) {
+            QuaternionWorker* worker = &p->workers[p->workerCount];
+            worker->pipeline = p;
+            worker->stage = s;
+            if (thrd_create(&worker->thread, runWorker, worker) != thrd_success) {
+                QuaternionPipeline_free(p);
+                return false;
+            }
+            p->workerCount++;
+        }
+    }
+    return true;
+}
+
+void QuaternionPipeline_free(QuaternionPipeline* p)
+{
+    assert(p != NULL);
+    atomic_store(&p->stopping, true);
+    for (size_t i = 0; i < p->workerCount; i++)
+        thrd_join(p->workers[i].thread, NULL);
+    if (p->queues != NULL) {
+        for (size_t s = 0; s <= p->stageCount; s++)
+            QuaternionQueue_free(&p->queues[s]);
+    }
+    free(p->stages);
+    free(p->counters);
+    free(p->queues);
+    free(p->workers);
+    *p = (QuaternionPipeline){0};
+}
+
+bool QuaternionPipeline_trySubmit(QuaternionPipeline* p, QuaternionBatch* batch)
+{
+    assert(batch != NULL);
+    batch->submitTime = nanoseconds();
+    return QuaternionQueue_push(&p->queues[0], batch);
+}
+
+void QuaternionPipeline_submit(QuaternionPipeline* p, QuaternionBatch* batch)
+{
+    while (!QuaternionPipeline_trySubmit(p, batch))
+        thrd_yield();
+}
+
+QuaternionBatch* QuaternionPipeline_tryReceive(QuaternionPipeline* p)
+{
+    return QuaternionQueue_pop(&p->queues[p->stageCount]);
+}
+
+QuaternionBatch* QuaternionPipeline_receive(QuaternionPipeline* p)
+{
+    QuaternionBatch* batch;
+    while ((batch = QuaternionPipeline_tryReceive(p)) == NULL)
+        thrd_yield();
+    return batch;
+}
+
+void QuaternionPipeline_getStats(QuaternionPipeline* p, size_t stage, QuaternionStageStats* output)
+{
+    assert(stage < p->stageCount);
+    assert(output != NULL);
+    QuaternionStageCounters* c = &p->counters[stage];
+    output->batches = atomic_load_explicit(&c->batches, memory_order_relaxed);
+    output->elements = atomic_load_explicit(&c->elements, memory_order_relaxed);
+    output->busyTime = atomic_load_explicit(&c->busyTime, memory_order_relaxed) * 1e-9;
+    output->stallTime = atomic_load_explicit(&c->stallTime, memory_order_relaxed) * 1e-9;
+    output->throughput = (output->busyTime > 0) ? output->elements / output->busyTime : 0;
+    output->meanLatency = (output->batches > 0)
+        ? atomic_load_explicit(&c->latency, memory_order_relaxed) * 1e-9 / output->batches : 0;
+    output->maxLatency = atomic_load_explicit(&c->maxLatency, memory_order_relaxed) * 1e-9;
+}
+
+void QuaternionPipeline_rotate(QuaternionBatch* batch, void* context)
+{
+    (void)context;
+    Quaternion_rotateArray(&batch->q, batch->v, batch->count, batch->v);
+}
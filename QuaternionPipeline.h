@@ -0,0 +1,227 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionPipeline.h
+ * @brief   Multi-threaded pipeline of stages connected by lock-free queues
+ * @date    2026-10-19
+ */
+#pragma once
+#include "Quaternion.h"
+#include <stdatomic.h>
+#include <threads.h>
+
+/**
+ * Size of a cache line. Indices written by different threads are kept this
+ * far apart, so that they do not invalidate each other's cache lines.
+ */
+#define QUATERNION_CACHE_LINE 64
+
+/**
+ * Block of orientations and vectors passed through a pipeline.
+ *
+ * Only the pointer to a batch is handed from stage to stage; its arrays are
+ * never copied. The application owns the memory and may recycle a batch as
+ * soon as it has been received at the end of the pipeline.
+ */
+typedef struct QuaternionBatch {
+    size_t count;                   /**< Number of valid elements */
+    size_t capacity;                /**< Number of allocated elements */
+    QuaternionArray q;              /**< Orientations */
+    double* v[3];                   /**< Vectors, e.g., sensor readings or points to rotate */
+    uint64_t submitTime;            /**< Set by QuaternionPipeline_submit(), monotonic nanoseconds */
+    void* user;                     /**< Free for use by the application */
+} QuaternionBatch;
+
+/**
+ * Allocates a batch with the given capacity and a count of zero.
+ * @return
+ *      False if allocation failed.
+ */
+bool QuaternionBatch_init(QuaternionBatch* batch, size_t capacity);
+
+/**
+ * Frees the arrays of a batch.
+ */
+void QuaternionBatch_free(QuaternionBatch* batch);
+
+typedef struct QuaternionQueueCell {
+    atomic_size_t sequence;         /**< Position the cell is ready for */
+    QuaternionBatch* batch;
+} QuaternionQueueCell;
+
+/**
+ * Bounded lock-free queue of batch pointers (ring buffer).
+ *
+ * A side used by a single thread advances its index with a plain store,
+ * a side shared by several threads claims positions with compare-and-swap.
+ * A full queue rejects further batches, which is how a slow stage applies
+ * backpressure to the stages before it.
+ */
+typedef struct QuaternionQueue {
+    QuaternionQueueCell* cells;
+    size_t mask;                    /**< Capacity - 1, the capacity is a power of two */
+    bool multiProducer;             /**< Whether several threads may push */
+    bool multiConsumer;             /**< Whether several threads may pop */
+    char padding0[QUATERNION_CACHE_LINE];
+    atomic_size_t tail;             /**< Next position to push */
+    char padding1[QUATERNION_CACHE_LINE];
+    atomic_size_t head;             /**< Next position to pop */
+    char padding2[QUATERNION_CACHE_LINE];
+} QuaternionQueue;
+
+/**
+ * Allocates a queue for at least capacity batches.
+ * @return
+ *      False if allocation failed.
+ */
+bool QuaternionQueue_init(QuaternionQueue* queue, size_t capacity, bool multiProducer, bool multiConsumer);
+
+/**
+ * Frees the memory of a queue. Batches still in the queue are not freed.
+ */
+void QuaternionQueue_free(QuaternionQueue* queue);
+
+/**
+ * Appends a batch to the queue without blocking.
+ * @return
+ *      False if the queue is full.
+ */
+bool QuaternionQueue_push(QuaternionQueue* queue, QuaternionBatch* batch);
+
+/**
+ * Removes the oldest batch from the queue without blocking.
+ * @return
+ *      The batch or NULL if the queue is empty.
+ */
+QuaternionBatch* QuaternionQueue_pop(QuaternionQueue* queue);
+
+/**
+ * Processes one batch in place. Runs on a worker thread of the pipeline.
+ */
+typedef void (*QuaternionStageFunction)(QuaternionBatch* batch, void* context);
+
+/**
+ * Description of a pipeline stage.
+ */
+typedef struct QuaternionStage {
+    const char* name;
+    QuaternionStageFunction function;
+    void* context;                  /**< Passed to every call of function */
+    unsigned threads;               /**< Worker threads, batches may be reordered if more than one */
+} QuaternionStage;
+
+/**
+ * Counters of a pipeline stage, updated by its workers.
+ */
+typedef struct QuaternionStageCounters {
+    atomic_uint_least64_t batches;
+    atomic_uint_least64_t elements;
+    atomic_uint_least64_t busyTime;     /**< Nanoseconds spent in the stage function */
+    atomic_uint_least64_t stallTime;    /**< Nanoseconds waiting for space in the next queue */
+    atomic_uint_least64_t latency;      /**< Sum of nanoseconds from submission to leaving the stage */
+    atomic_uint_least64_t maxLatency;
+    char padding[QUATERNION_CACHE_LINE];
+} QuaternionStageCounters;
+
+/**
+ * Snapshot of the counters of a stage.
+ */
+typedef struct QuaternionStageStats {
+    uint64_t batches;               /**< Batches processed */
+    uint64_t elements;              /**< Elements processed */
+    double busyTime;                /**< Seconds spent in the stage function */
+    double stallTime;               /**< Seconds blocked by backpressure of the next stage */
+    double throughput;              /**< Elements per busy second of a single worker */
+    double meanLatency;             /**< Seconds from submission until the batch left the stage */
+    double maxLatency;
+} QuaternionStageStats;
+
+typedef struct QuaternionWorker {
+    struct QuaternionPipeline* pipeline;
+    size_t stage;
+    thrd_t thread;
+} QuaternionWorker;
+
+/**
+ * Chain of stages, each running on its own worker threads.
+ *
+ * queues[s] feeds stage s, so queues[0] receives submitted batches and
+ * queues[stageCount] holds the processed ones. A queue only uses the
+ * multi-producer or multi-consumer protocol if an adjacent stage has more
+ * than one worker. QuaternionPipeline_submit() and QuaternionPipeline_receive()
+ * must each be called from one thread at a time.
+ */
+typedef struct QuaternionPipeline {
+    size_t stageCount;
+    QuaternionStage* stages;            /**< Copy of the stage descriptions */
+    QuaternionStageCounters* counters;  /**< Counters per stage */
+    QuaternionQueue* queues;            /**< stageCount + 1 queues */
+    QuaternionWorker* workers;
+    size_t workerCount;                 /**< Number of started workers */
+    atomic_bool stopping;
+} QuaternionPipeline;
+
+/**
+ * Creates the queues and starts the worker threads of all stages.
+ * The workers keep a pointer to p, so it must not be moved until freed.
+ * @param queueCapacity
+ *      Batches each queue can hold before it applies backpressure.
+ * @return
+ *      False if allocation or starting a thread failed.
+ */
+bool QuaternionPipeline_init(QuaternionPipeline* p, const QuaternionStage* stages, size_t stageCount, size_t queueCapacity);
+
+/**
+ * Stops and joins all workers and frees the queues. Batches still in the
+ * pipeline are abandoned but not freed, as they belong to the application.
+ */
+void QuaternionPipeline_free(QuaternionPipeline* p);
+
+/**
+ * Passes a batch to the first stage without blocking.
+ * @return
+ *      False if the first queue is full (backpressure).
+ */
+bool QuaternionPipeline_trySubmit(QuaternionPipeline* p, QuaternionBatch* batch);
+
+/**
+ * Passes a batch to the first stage, waiting while the first queue is full.
+ */
+void QuaternionPipeline_submit(QuaternionPipeline* p, QuaternionBatch* batch);
+
+/**
+ * Takes a processed batch from the last stage without blocking.
+ * @return
+ *      The batch or NULL if no batch is ready.
+ */
+QuaternionBatch* QuaternionPipeline_tryReceive(QuaternionPipeline* p);
+
+/**
+ * Takes a processed batch from the last stage, waiting until one is ready.
+ */
+QuaternionBatch* QuaternionPipeline_receive(QuaternionPipeline* p);
+
+/**
+ * Reads the counters of a stage. Can be called while the pipeline runs.
+ * Batches, elements and busy time include every batch that has left the
+ * stage; its stall time and latency may be added shortly afterwards.
+ */
+void QuaternionPipeline_getStats(QuaternionPipeline* p, size_t stage, QuaternionStageStats* output);
+
+/**
+ * Stage function that rotates the vectors of a batch by its orientations,
+ * using Quaternion_rotateArray(). The context is unused.
+ */
+void QuaternionPipeline_rotate(QuaternionBatch* batch, void* context);
@@ -0,0 +1,291 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionScan.c
+ * @brief   Parallel prefix products (scan) and reductions of quaternion arrays
+ * @date    2026-10-19
+ */
+#include "QuaternionScan.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <threads.h>
+
+/*
+ * The Hamilton product is associative, so the array can be split into
+ * blocks that are scanned independently and joined afterwards:
+ *
+ *  1. Each block is scanned (or reduced) locally. Four adjacent blocks are
+ *     processed together, so four independent dependency chains overlap.
+ *  2. The block totals are scanned sequentially, giving the product of all
+ *     elements before each block. Renormalization happens here.
+ *  3. Each scanned block is multiplied by the product of all blocks before
+ *     it. This is a vectorizable loop with a constant factor.
+ *
+ * Steps 1 and 3 are distributed over threads in contiguous ranges of groups
+ * (four blocks each). The order of all products is kept, so the result only
+ * differs from a sequential fold by rounding.
+ */
+
+#define CHAINS 4
+#define DEFAULT_BLOCK_SIZE 1024
+#define MAX_THREADS 64
+
+typedef struct ScanJob {
+    const double* q[4];             /**< Input arrays (w, x, y, z) */
+    double* output[4];              /**< Output arrays, NULL for a reduction */
+    size_t count;
+    size_t blockSize;
+    size_t groups;                  /**< Number of groups of CHAINS blocks */
+    bool right;
+    bool exclusive;
+    Quaternion* totals;             /**< Per block: local total, after step 2 the prefix before it */
+} ScanJob;
+
+typedef struct ScanRange {
+    ScanJob* job;
+    size_t first;                   /**< First group */
+    size_t last;                    /**< One past the last group */
+    bool join;                      /**< Step 3 instead of step 1 */
+    thrd_t thread;
+} ScanRange;
+
+/**
+ * Same formula as Quaternion_multiply(), inlined so that the running
+ * products stay in registers and the loop of step 3 can be vectorized.
+ */
+static inline void multiply(const Quaternion* a, const Quaternion* b, Quaternion* output)
+{
+    Quaternion r;
+    r.w    = a->w   *b->w    - a->v[0]*b->v[0] - a->v[1]*b->v[1] - a->v[2]*b->v[2];
+    r.v[0] = a->v[0]*b->w    + a->w   *b->v[0] + a->v[1]*b->v[2] - a->v[2]*b->v[1];
+    r.v[1] = a->w   *b->v[1] - a->v[0]*b->v[2] + a->v[1]*b->w    + a->v[2]*b->v[0];
+    r.v[2] = a->w   *b->v[2] + a->v[0]*b->v[1] - a->v[1]*b->v[0] + a->v[2]*b->w   ;
+    *output = r;
+}
+
+/**
+ * Multiplies element i onto the running product and stores the product
+ * before (exclusive) or after (inclusive) that, if there is an output.
+ */
+static inline void step(ScanJob* job, Quaternion* product, size_t i)
+{
+    Quaternion q = {job->q[0][i], {job->q[1][i], job->q[2][i], job->q[3][i]}};
+    QuaternionArray output = {job->output[0], {job->output[1], job->output[2], job->output[3]}};
+    if (job->exclusive && output.w != NULL)
+        Quaternion_store(product, &output, i);
+    if (job->right)
+        multiply(product, &q, product);
+    else
+        multiply(&q, product, product);
+    if (!job->exclusive && output.w != NULL)
+        Quaternion_store(product, &output, i);
+}
+
+static void blockRange(ScanJob* job, size_t block, size_t* begin, size_t* end)
+{
+    size_t b = block * job->blockSize;
+    *begin = (b < job->count) ? b : job->count;
+    *end = (b + job->blockSize < job->count) ? b + job->blockSize : job->count;
+}
+
+/**
+ * Step 1 for one group: scans CHAINS blocks side by side. These are scalar
+ * dependency chains, interleaved so that their latencies overlap.
+ */
+static void scanGroup(ScanJob* job, size_t group)
+{
+    size_t begin[CHAINS], end[CHAINS], shortest = job->blockSize;
+    Quaternion product[CHAINS];
+    for (int j = 0; j < CHAINS; j++) {
+        blockRange(job, group * CHAINS + j, &begin[j], &end[j]);
+        shortest = (end[j] - begin[j] < shortest) ? end[j] - begin[j] : shortest;
+        Quaternion_setIdentity(&product[j]);
+    }
+
+    for (size_t k = 0; k < shortest; k++) {
+        for (int j = 0; j < CHAINS; j++)
+            step(job, &product[j], begin[j] + k);
+    }
+
+    // Remaining elements of the shorter last block
+    for (int j = 0; j < CHAINS; j++) {
+        for (size_t i = begin[j] + shortest; i < end[j]; i++)
+            step(job, &product[j], i);
+        job->totals[group * CHAINS + j] = product[j];
+    }
+}
+
+/**
+ * Step 3 for one block: output[i] = prefix * output[i] (right order) or
+ * output[i] * prefix (left order).
+ */
+static void joinBlock(ScanJob* job, size_t block)
+{
+    size_t begin, end;
+    blockRange(job, block, &begin, &end);
+    Quaternion p = job->totals[block];
+    double* ow = job->output[0];
+    double* ox = job->output[1];
+    double* oy = job->output[2];
+    double* oz = job->output[3];
+
+    if (job->right) {
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = begin; i < end; i++) {
+            Quaternion a = {ow[i], {ox[i], oy[i], oz[i]}}, r;
+            multiply(&p, &a, &r);
+            ow[i] = r.w;
+            ox[i] = r.v[0];
+            oy[i] = r.v[1];
+            oz[i] = r.v[2];
+        }
+    } else {
+        QUATERNION_INDEPENDENT_LOOP
+        for (size_t i = begin; i < end; i++) {
+            Quaternion a = {ow[i], {ox[i], oy[i], oz[i]}}, r;
+            multiply(&a, &p, &r);
+            ow[i] = r.w;
+            ox[i] = r.v[0];
+            oy[i] = r.v[1];
+            oz[i] = r.v[2];
+        }
+    }
+}
+
+static int runRange(void* arg)
+{
+    ScanRange* range = arg;
+    ScanJob* job = range->job;
+    for (size_t g = range->first; g < range->last; g++) {
+        if (!range->join) {
+            scanGroup(job, g);
+        } else {
+            // The first block of the array needs no correction
+            for (size_t b = g * CHAINS; b < (g + 1) * CHAINS; b++) {
+                if (b > 0)
+                    joinBlock(job, b);
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs step 1 or 3 for all groups. Ranges whose thread cannot be started
+ * run on the calling thread.
+ */
+static void runParallel(ScanJob* job, ScanRange* ranges, unsigned threads, bool join)
+{
+    for (unsigned t = 0; t < threads; t++) {
+        ranges[t].job = job;
+        ranges[t].first = job->groups * t / threads;
+        ranges[t].last = job->groups * (t + 1) / threads;
+        ranges[t].join = join;
+    }
+    bool started[MAX_THREADS] = {false};
+    for (unsigned t = 1; t < threads; t++)
+        started[t] = thrd_create(&ranges[t].thread, runRange, &ranges[t]) == thrd_success;
+    runRange(&ranges[0]);
+    for (unsigned t = 1; t < threads; t++) {
+        if (started[t])
+            thrd_join(ranges[t].thread, NULL);
+        else
+            runRange(&ranges[t]);
+    }
+}
+
+static void scan(QuaternionArray* q, size_t count, const QuaternionScanOptions* options,
+    QuaternionArray* output, bool exclusive, Quaternion* total)
+{
+    QuaternionScanOptions defaults = {QUATERNION_SCAN_RIGHT, 1, DEFAULT_BLOCK_SIZE, false};
+    if (options == NULL)
+        options = &defaults;
+
+    ScanJob job = {0};
+    job.q[0] = q->w;
+    job.q[1] = q->v[0];
+    job.q[2] = q->v[1];
+    job.q[3] = q->v[2];
+    if (output != NULL) {
+        job.output[0] = output->w;
+        job.output[1] = output->v[0];
+        job.output[2] = output->v[1];
+        job.output[3] = output->v[2];
+    }
+    job.count = count;
+    job.blockSize = (options->blockSize > 0) ? options->blockSize : DEFAULT_BLOCK_SIZE;
+    job.right = options->order == QUATERNION_SCAN_RIGHT;
+    job.exclusive = exclusive;
+
+    size_t blocks = (count + job.blockSize - 1) / job.blockSize;
+    job.groups = (blocks + CHAINS - 1) / CHAINS;
+    unsigned threads = (options->threads > 0) ? options->threads : 1;
+    threads = (threads > MAX_THREADS) ? MAX_THREADS : threads;
+    threads = (threads > job.groups) ? (unsigned)job.groups : threads;
+    threads = (threads > 0) ? threads : 1;
+
+    Quaternion fallback[CHAINS];
+    job.totals = malloc(job.groups * CHAINS * sizeof(Quaternion));
+    if (job.totals == NULL) {
+        // Sequential fold in a single block
+        job.blockSize = (count > 0) ? count : 1;
+        job.groups = 1;
+        blocks = 1;
+        job.totals = fallback;
+        threads = 1;
+    }
+
+    ScanRange ranges[MAX_THREADS];
+    runParallel(&job, ranges, threads, false);
+
+    // Step 2: product of all blocks before each block
+    Quaternion prefix;
+    Quaternion_setIdentity(&prefix);
+    for (size_t b = 0; b < job.groups * CHAINS; b++) {
+        Quaternion t = job.totals[b];
+        job.totals[b] = prefix;
+        if (job.right)
+            Quaternion_multiply(&prefix, &t, &prefix);
+        else
+            Quaternion_multiply(&t, &prefix, &prefix);
+        if (options->normalize)
+            Quaternion_normalize(&prefix, &prefix);
+    }
+    if (total != NULL)
+        *total = prefix;
+
+    if (output != NULL && blocks > 1)
+        runParallel(&job, ranges, threads, true);
+    if (job.totals != fallback)
+        free(job.totals);
+}
+
+void QuaternionScan_reduce(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, Quaternion* output)
+{
+    assert(output != NULL);
+    scan(q, count, options, NULL, false, output);
+}
+
+void QuaternionScan_inclusive(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, QuaternionArray* output)
+{
+    assert(output != NULL);
+    scan(q, count, options, output, false, NULL);
+}
+
+void QuaternionScan_exclusive(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, QuaternionArray* output)
+{
+    assert(output != NULL);
+    scan(q, count, options, output, true, NULL);
+}
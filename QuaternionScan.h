@@ -0,0 +1,62 @@
+// Copyright (C) 2026 Martin Weigel <mail@MartinWeigel.com>
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+// WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+// ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+// WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+// ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+// OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+
+/**
+ * @file    QuaternionScan.h
+ * @brief   Parallel prefix products (scan) and reductions of quaternion arrays
+ * @date    2026-10-19
+ */
+#pragma once
+#include "Quaternion.h"
+
+/**
+ * Side on which each new element is multiplied onto the running product.
+ */
+typedef enum QuaternionScanOrder {
+    /** Quaternion_multiply(product, q[i]): q[0] * q[1] * ... * q[i],
+     *  e.g., a serial kinematic chain of local rotations */
+    QUATERNION_SCAN_RIGHT,
+    /** Quaternion_multiply(q[i], product): q[i] * ... * q[1] * q[0],
+     *  e.g., integrating rotations given in the global frame */
+    QUATERNION_SCAN_LEFT
+} QuaternionScanOrder;
+
+/**
+ * Options of a scan or reduction. NULL selects the defaults: right order,
+ * one thread, blocks of 1024 elements and no renormalization.
+ */
+typedef struct QuaternionScanOptions {
+    QuaternionScanOrder order;
+    unsigned threads;           /**< Number of threads including the caller, 0 for one */
+    size_t blockSize;           /**< Elements per block, 0 for the default */
+    bool normalize;             /**< Renormalize the running product at block boundaries */
+} QuaternionScanOptions;
+
+/**
+ * Multiplies all quaternions in the given order. The identity is returned
+ * for an empty array.
+ */
+void QuaternionScan_reduce(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, Quaternion* output);
+
+/**
+ * Inclusive scan: output[i] is the product of q[0] to q[i].
+ * The output may be the input array.
+ */
+void QuaternionScan_inclusive(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, QuaternionArray* output);
+
+/**
+ * Exclusive scan: output[0] is the identity and output[i] is the product of
+ * q[0] to q[i - 1]. The output may be the input array.
+ */
+void QuaternionScan_exclusive(QuaternionArray* q, size_t count, const QuaternionScanOptions* options, QuaternionArray* output);
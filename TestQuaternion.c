@@ -1,5 +1,6 @@
 // TEST: gcc -std=c17 -Wall -Wextra TestQuaternion.c Quaternion.c -o TestQuaternion.exe; ./TestQuaternion.exe
 #include <stdlib.h>
+#include <float.h>
 #include "Quaternion.h"
 
 #ifndef M_PI
@@ -53,6 +54,19 @@ void testQuaternion_copy(void)
     ASSERT_SAME_DOUBLE("Quaternion_copy has wrong v[2]", r.v[2], q.v[2]);
 }
 
+void testQuaternion_loadStore(void)
+{
+    double w[2], x[2], y[2], z[2];
+    QuaternionArray array = {w, {x, y, z}};
+    Quaternion q, r;
+    Quaternion_set(5.1, 4.2, 3.3, 2.4, &q);
+    Quaternion_store(&q, &array, 1);
+    ASSERT_SAME_DOUBLE("Quaternion_store should set w", w[1], 5.1);
+    ASSERT_SAME_DOUBLE("Quaternion_store should set v[2]", z[1], 2.4);
+    Quaternion_load(&array, 1, &r);
+    ASSERT_TRUE("Quaternion_load should inverse Quaternion_store", Quaternion_equal(&q, &r));
+}
+
 void testQuaternion_conjugate(void)
 {
     Quaternion q, c;
@@ -102,6 +116,11 @@ void testQuaternion_normalize(void)
     Quaternion_normalize(&q, &c);
     ASSERT_SAME_DOUBLE("Quaternion_normalize was not 1", Quaternion_norm(&q), sqrt(126));
     ASSERT_SAME_DOUBLE("Quaternion_normalize is 1 afterwards", Quaternion_norm(&c), 1);
+
+    // The zero quaternion has no direction
+    Quaternion_set(0, 0, 0, 0, &q);
+    Quaternion_normalize(&q, &c);
+    ASSERT_TRUE("Quaternion_normalize of zero is NaN", isnan(c.w) && isnan(c.v[0]));
 }
 
 void testQuaternion_fromAxisAngle(void)
@@ -313,11 +332,387 @@ void testQuaternion_slerp(void)
     ASSERT_SAME_DOUBLE("Quaternion_slerp with t=0.62 (v[2])", result.v[2], 0.6119266025696755);
 }
 
+void testQuaternion_expLog(void)
+{
+    Quaternion q, result, real;
+    Quaternion_set(0, 0, 0, TO_RAD(45.0), &q);
+    Quaternion_exp(&q, &result);
+    Quaternion_fromZRotation(TO_RAD(90.0), &real);
+    ASSERT_TRUE("Quaternion_exp of pure quaternion", Quaternion_equal(&result, &real));
+
+    Quaternion_set(1, 0, 0, 0, &q);
+    Quaternion_exp(&q, &result);
+    ASSERT_SAME_DOUBLE("Quaternion_exp of real quaternion", result.w, exp(1));
+
+    Quaternion_set(2, 0.5, -1.5, 1, &q);
+    Quaternion_log(&q, &result);
+    Quaternion_exp(&result, &result);
+    ASSERT_TRUE("Quaternion_exp inverts Quaternion_log", Quaternion_equal(&result, &q));
+
+    Quaternion_set(-1, 0, 0, 0, &q);
+    Quaternion_log(&q, &result);
+    ASSERT_SAME_DOUBLE("Quaternion_log of -1", result.v[0], M_PI);
+}
+
+void testQuaternion_pow(void)
+{
+    Quaternion q, result, real;
+    Quaternion_fromYRotation(TO_RAD(90.0), &q);
+    Quaternion_pow(&q, 0.5, &result);
+    Quaternion_fromYRotation(TO_RAD(45.0), &real);
+    ASSERT_TRUE("Quaternion_pow with t=0.5", Quaternion_equal(&result, &real));
+
+    Quaternion_pow(&q, -1, &result);
+    Quaternion_conjugate(&q, &real);
+    ASSERT_TRUE("Quaternion_pow with t=-1", Quaternion_equal(&result, &real));
+}
+
+void testQuaternion_boxplusBoxminus(void)
+{
+    Quaternion q1, q2, result, real;
+    double delta[3] = {0, 0, TO_RAD(30.0)}, d[3];
+    Quaternion_fromXRotation(TO_RAD(90.0), &q1);
+    Quaternion_boxplus(&q1, delta, &result);
+    Quaternion_fromZRotation(TO_RAD(30.0), &q2);
+    Quaternion_multiply(&q1, &q2, &real);
+    ASSERT_TRUE("Quaternion_boxplus rotates in the local frame", Quaternion_equal(&result, &real));
+
+    Quaternion_boxminus(&result, &q1, d);
+    ASSERT_SAME_DOUBLE("Quaternion_boxminus (X-axis)", d[0], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_boxminus (Y-axis)", d[1], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_boxminus (Z-axis)", d[2], TO_RAD(30.0));
+
+    // Both signs of a quaternion describe the same rotation
+    Quaternion_set(-result.w, -result.v[0], -result.v[1], -result.v[2], &result);
+    Quaternion_boxminus(&result, &q1, d);
+    ASSERT_SAME_DOUBLE("Quaternion_boxminus uses the shortest path", d[2], TO_RAD(30.0));
+}
+
+void testQuaternion_expLogArray(void)
+{
+    double vx[3] = {0, 1e-9, 0.3}, vy[3] = {0, 0, -1.2}, vz[3] = {TO_RAD(45.0), 0, 0.7};
+    double w[3], x[3], y[3], z[3], lx[3], ly[3], lz[3];
+    double* v[3] = {vx, vy, vz};
+    double* l[3] = {lx, ly, lz};
+    QuaternionArray array = {w, {x, y, z}};
+    Quaternion q, result;
+
+    Quaternion_expArray(v, 3, &array);
+    for(int i = 0; i < 3; i++) {
+        Quaternion_set(0, vx[i], vy[i], vz[i], &q);
+        Quaternion_exp(&q, &q);
+        Quaternion_load(&array, i, &result);
+        ASSERT_TRUE("Quaternion_expArray matches Quaternion_exp", Quaternion_equal(&result, &q));
+    }
+
+    Quaternion_logArray(&array, 3, l);
+    for(int i = 0; i < 3; i++) {
+        ASSERT_SAME_DOUBLE("Quaternion_logArray inverts Quaternion_expArray (X-axis)", lx[i], vx[i]);
+        ASSERT_SAME_DOUBLE("Quaternion_logArray inverts Quaternion_expArray (Y-axis)", ly[i], vy[i]);
+        ASSERT_SAME_DOUBLE("Quaternion_logArray inverts Quaternion_expArray (Z-axis)", lz[i], vz[i]);
+    }
+
+    // Rotation by 360 degrees has no axis: X-axis as in Quaternion_log()
+    Quaternion_set(-1, 0, 0, 0, &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_logArray(&array, 1, l);
+    ASSERT_SAME_DOUBLE("Quaternion_logArray of -1 (X-axis)", lx[0], M_PI);
+    ASSERT_SAME_DOUBLE("Quaternion_logArray of -1 (Y-axis)", ly[0], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_logArray of -1 (Z-axis)", lz[0], 0);
+}
+
+void testQuaternion_powBoxArray(void)
+{
+    double w[3], x[3], y[3], z[3], pw[3], px[3], py[3], pz[3];
+    double t[3] = {0.5, -2, 0};
+    double dx[3], dy[3], dz[3];
+    double* d[3] = {dx, dy, dz};
+    QuaternionArray array = {w, {x, y, z}};
+    QuaternionArray result = {pw, {px, py, pz}};
+    Quaternion q, p, real;
+    double e[3] = {TO_RAD(30.0), TO_RAD(-20.0), TO_RAD(60.0)};
+
+    Quaternion_fromXRotation(TO_RAD(90.0), &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_fromEulerZYX(e, &q);
+    Quaternion_store(&q, &array, 1);
+    Quaternion_fromZRotation(TO_RAD(-170.0), &q);
+    Quaternion_store(&q, &array, 2);
+
+    Quaternion_powArray(&array, t, 3, &result);
+    for(int i = 0; i < 3; i++) {
+        Quaternion_load(&array, i, &q);
+        Quaternion_pow(&q, t[i], &real);
+        Quaternion_load(&result, i, &p);
+        ASSERT_TRUE("Quaternion_powArray matches Quaternion_pow", Quaternion_equal(&p, &real));
+    }
+
+    // Half of a rotation by 360 degrees around the X-axis as in Quaternion_pow()
+    Quaternion_set(-1, 0, 0, 0, &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_powArray(&array, t, 1, &result);
+    Quaternion_load(&result, 0, &p);
+    Quaternion_set(0, 1, 0, 0, &real);
+    ASSERT_TRUE("Quaternion_powArray of -1 keeps the X-axis", Quaternion_equal(&p, &real));
+    Quaternion_fromXRotation(TO_RAD(90.0), &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_powArray(&array, t, 3, &result);
+
+    Quaternion_boxminusArray(&result, &array, 3, d);
+    Quaternion_boxplusArray(&array, d, 3, &result);
+    for(int i = 0; i < 3; i++) {
+        Quaternion_load(&array, i, &q);
+        Quaternion_pow(&q, t[i], &real);
+        Quaternion_load(&result, i, &p);
+        // Equal up to sign, as the shortest rotation is used
+        if(p.w * real.w < 0)
+            Quaternion_set(-p.w, -p.v[0], -p.v[1], -p.v[2], &p);
+        ASSERT_TRUE("Quaternion_boxplusArray inverts Quaternion_boxminusArray", Quaternion_equal(&p, &real));
+    }
+}
+
+void testQuaternion_rotateArray(void)
+{
+    double w[2], x[2], y[2], z[2];
+    double vx[2] = {1, 0.5}, vy[2] = {0, -2}, vz[2] = {0, 3};
+    double* v[3] = {vx, vy, vz};
+    QuaternionArray array = {w, {x, y, z}};
+    Quaternion q;
+    double e[3] = {TO_RAD(30.0), TO_RAD(-20.0), TO_RAD(60.0)}, real[3], input[3] = {0.5, -2, 3};
+
+    Quaternion_fromZRotation(TO_RAD(90.0), &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_fromEulerZYX(e, &q);
+    Quaternion_store(&q, &array, 1);
+
+    // In place
+    Quaternion_rotateArray(&array, v, 2, v);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray (X-axis)", vx[0], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray (Y-axis)", vy[0], 1);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray (Z-axis)", vz[0], 0);
+    Quaternion_rotate(&q, input, real);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray matches Quaternion_rotate (X-axis)", vx[1], real[0]);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray matches Quaternion_rotate (Y-axis)", vy[1], real[1]);
+    ASSERT_SAME_DOUBLE("Quaternion_rotateArray matches Quaternion_rotate (Z-axis)", vz[1], real[2]);
+}
+
+void testQuaternion_fromTwoVectors(void)
+{
+    Quaternion q, real, identity;
+    double x[3] = {2, 0, 0}, y[3] = {0, 0.5, 0}, v[3] = {1, -2, 3}, minusV[3] = {-2, 4, -6}, result[3];
+    Quaternion_setIdentity(&identity);
+
+    Quaternion_fromTwoVectors(x, y, &q);
+    Quaternion_fromZRotation(TO_RAD(90.0), &real);
+    ASSERT_TRUE("Quaternion_fromTwoVectors X-axis to Y-axis", Quaternion_equal(&q, &real));
+
+    Quaternion_fromTwoVectors(v, v, &q);
+    ASSERT_TRUE("Quaternion_fromTwoVectors with parallel vectors", Quaternion_equal(&q, &identity));
+
+    Quaternion_fromTwoVectors(v, minusV, &q);
+    Quaternion_rotate(&q, v, result);
+    ASSERT_SAME_DOUBLE("Quaternion_fromTwoVectors with opposite vectors (w)", q.w, 0);
+    ASSERT_SAME_DOUBLE("Quaternion_fromTwoVectors with opposite vectors (X-axis)", result[0], -1);
+    ASSERT_SAME_DOUBLE("Quaternion_fromTwoVectors with opposite vectors (Y-axis)", result[1], 2);
+    ASSERT_SAME_DOUBLE("Quaternion_fromTwoVectors with opposite vectors (Z-axis)", result[2], -3);
+
+    double zero[3] = {0, 0, 0};
+    Quaternion_fromTwoVectors(zero, v, &q);
+    ASSERT_TRUE("Quaternion_fromTwoVectors with zero vector", Quaternion_equal(&q, &identity));
+
+    // Squared lengths would overflow or underflow
+    double hugeX[3] = {1e300, 0, 0}, hugeY[3] = {0, 1e100, 0};
+    double tinyX[3] = {1e-160, 0, 0}, tinyY[3] = {0, 5e-324, 0};
+    Quaternion_fromZRotation(TO_RAD(90.0), &real);
+    Quaternion_fromTwoVectors(hugeX, hugeY, &q);
+    ASSERT_TRUE("Quaternion_fromTwoVectors with huge vectors", Quaternion_equal(&q, &real));
+    Quaternion_fromTwoVectors(tinyX, tinyY, &q);
+    ASSERT_TRUE("Quaternion_fromTwoVectors with tiny vectors", Quaternion_equal(&q, &real));
+    Quaternion_fromTwoVectors(tinyX, hugeY, &q);
+    ASSERT_TRUE("Quaternion_fromTwoVectors with tiny and huge vector", Quaternion_equal(&q, &real));
+    double largest[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, diagonal[3] = {1, 1, 1};
+    Quaternion_fromTwoVectors(largest, hugeY, &q);
+    Quaternion_rotate(&q, diagonal, result);
+    ASSERT_SAME_DOUBLE("Quaternion_fromTwoVectors with largest vector", result[1], sqrt(3));
+}
+
+void testQuaternion_lookRotation(void)
+{
+    Quaternion q;
+    double forward[3] = {3, 0, 0}, up[3] = {0, 0, 2}, z[3] = {0, 0, 1}, y[3] = {0, 1, 0}, result[3];
+    Quaternion_lookRotation(forward, up, &q);
+    Quaternion_rotate(&q, z, result);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation Z-axis to forward (X-axis)", result[0], 1);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation Z-axis to forward (Z-axis)", result[2], 0);
+    Quaternion_rotate(&q, y, result);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation Y-axis to up (X-axis)", result[0], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation Y-axis to up (Z-axis)", result[2], 1);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation is normalized", Quaternion_norm(&q), 1);
+
+    // Up parallel to forward
+    double tilted[3] = {0, -1, -1};
+    Quaternion_lookRotation(tilted, tilted, &q);
+    Quaternion_rotate(&q, z, result);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation with parallel up (X-axis)", result[0], 0);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation with parallel up (Y-axis)", result[1], -sqrt(0.5));
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation with parallel up (Z-axis)", result[2], -sqrt(0.5));
+
+    // Zero forward vector
+    Quaternion identity;
+    double zero[3] = {0, 0, 0};
+    Quaternion_setIdentity(&identity);
+    Quaternion_lookRotation(zero, up, &q);
+    ASSERT_TRUE("Quaternion_lookRotation with zero forward", Quaternion_equal(&q, &identity));
+
+    // Squared lengths would overflow or underflow
+    Quaternion real;
+    double hugeForward[3] = {1e300, 0, 0}, tinyUp[3] = {0, 0, 1e-160};
+    Quaternion_lookRotation(forward, up, &real);
+    Quaternion_lookRotation(hugeForward, tinyUp, &q);
+    ASSERT_TRUE("Quaternion_lookRotation with huge forward and tiny up", Quaternion_equal(&q, &real));
+    Quaternion_lookRotation(tinyUp, hugeForward, &q);
+    Quaternion_rotate(&q, z, result);
+    ASSERT_SAME_DOUBLE("Quaternion_lookRotation with tiny forward (Z-axis)", result[2], 1);
+}
+
+void testQuaternion_fromTwoVectorsArray(void)
+{
+    double ax[3] = {1, 0, 1}, ay[3] = {0, 1, 2}, az[3] = {0, 0, 3};
+    double bx[3] = {0, 0, -1}, by[3] = {1, 1, -2}, bz[3] = {0, 1, -3};
+    double* a[3] = {ax, ay, az};
+    double* b[3] = {bx, by, bz};
+    double w[3], x[3], y[3], z[3];
+    QuaternionArray array = {w, {x, y, z}};
+    Quaternion q, real;
+
+    Quaternion_fromTwoVectorsArray(a, b, 3, &array);
+    for(int i = 0; i < 3; i++) {
+        double from[3] = {ax[i], ay[i], az[i]}, to[3] = {bx[i], by[i], bz[i]};
+        Quaternion_fromTwoVectors(from, to, &real);
+        Quaternion_load(&array, i, &q);
+        ASSERT_TRUE("Quaternion_fromTwoVectorsArray matches Quaternion_fromTwoVectors", Quaternion_equal(&q, &real));
+    }
+
+    Quaternion_lookRotationArray(a, b, 3, &array);
+    for(int i = 0; i < 3; i++) {
+        double forward[3] = {ax[i], ay[i], az[i]}, up[3] = {bx[i], by[i], bz[i]};
+        Quaternion_lookRotation(forward, up, &real);
+        Quaternion_load(&array, i, &q);
+        ASSERT_TRUE("Quaternion_lookRotationArray matches Quaternion_lookRotation", Quaternion_equal(&q, &real));
+    }
+}
+
+void testQuaternion_slerpArray(void)
+{
+    double w1[4], x1[4], y1[4], z1[4], w2[4], x2[4], y2[4], z2[4], w[4], x[4], y[4], z[4];
+    double t[4] = {0, 1, 0.62, 0.3};
+    QuaternionArray q1 = {w1, {x1, y1, z1}}, q2 = {w2, {x2, y2, z2}}, result = {w, {x, y, z}};
+    Quaternion a, b, q, real;
+    Quaternion_set(0.6532815, -0.270598, 0.270598, 0.6532815, &a);
+    Quaternion_set(0.5, 0.5, 0.5, 0.5, &b);
+    for(int i = 0; i < 3; i++) {
+        Quaternion_store(&a, &q1, i);
+        Quaternion_store(&b, &q2, i);
+    }
+    // Equal quaternions
+    Quaternion_store(&b, &q1, 3);
+    Quaternion_store(&b, &q2, 3);
+
+    Quaternion_slerpArray(&q1, &q2, t, 4, false, &result);
+    for(int i = 0; i < 4; i++) {
+        Quaternion_load(&q1, i, &a);
+        Quaternion_slerp(&a, &b, t[i], &real);
+        Quaternion_load(&result, i, &q);
+        ASSERT_TRUE("Quaternion_slerpArray matches Quaternion_slerp", Quaternion_equal(&q, &real));
+    }
+
+    // The shortest path ignores the sign of q2
+    Quaternion_set(-0.5, -0.5, -0.5, -0.5, &b);
+    for(int i = 0; i < 4; i++)
+        Quaternion_store(&b, &q2, i);
+    Quaternion_slerpArray(&q1, &q2, t, 4, true, &result);
+    Quaternion_load(&result, 2, &q);
+    ASSERT_SAME_DOUBLE("Quaternion_slerpArray along the shortest path (w)", q.w, 0.6119266025696755);
+    ASSERT_SAME_DOUBLE("Quaternion_slerpArray along the shortest path (v[0])", q.v[0], 0.22069444274723088);
+    ASSERT_SAME_DOUBLE("Quaternion_slerpArray along the shortest path (v[1])", q.v[1], 0.4498729015909088);
+    ASSERT_SAME_DOUBLE("Quaternion_slerpArray along the shortest path (v[2])", q.v[2], 0.6119266025696755);
+    Quaternion_load(&result, 3, &q);
+    Quaternion_set(0.5, 0.5, 0.5, 0.5, &real);
+    ASSERT_TRUE("Quaternion_slerpArray of opposite quaternions along the shortest path", Quaternion_equal(&q, &real));
+
+    // Exactly opposite quaternions give q1, as in Quaternion_slerp()
+    Quaternion_slerpArray(&q1, &q2, t, 4, false, &result);
+    Quaternion_load(&result, 3, &q);
+    Quaternion_load(&q1, 3, &a);
+    Quaternion_slerp(&a, &b, t[3], &real);
+    ASSERT_TRUE("Quaternion_slerpArray of exactly opposite quaternions", Quaternion_equal(&q, &a));
+    ASSERT_TRUE("Quaternion_slerpArray of exactly opposite quaternions matches Quaternion_slerp", Quaternion_equal(&q, &real));
+}
+
+void testQuaternion_swingTwist(void)
+{
+    Quaternion q, swing, twist, real, result;
+    double axis[3] = {0, 0, 3};
+    Quaternion swingReal, twistReal;
+    Quaternion_fromXRotation(TO_RAD(90.0), &swingReal);
+    Quaternion_fromZRotation(TO_RAD(-120.0), &twistReal);
+    Quaternion_multiply(&swingReal, &twistReal, &q);
+
+    // A swing of 90 degrees is gimbal lock for Euler angles, but not here
+    Quaternion_swingTwist(&q, axis, &swing, &twist);
+    ASSERT_TRUE("Quaternion_swingTwist (swing)", Quaternion_equal(&swing, &swingReal));
+    ASSERT_TRUE("Quaternion_swingTwist (twist)", Quaternion_equal(&twist, &twistReal));
+    Quaternion_fromSwingTwist(&swing, &twist, &result);
+    ASSERT_TRUE("Quaternion_fromSwingTwist", Quaternion_equal(&result, &q));
+
+    // The twist is chosen with a non-negative w
+    Quaternion_set(-q.w, -q.v[0], -q.v[1], -q.v[2], &q);
+    Quaternion_swingTwist(&q, axis, &swing, &twist);
+    ASSERT_TRUE("Quaternion_swingTwist of -q (twist)", Quaternion_equal(&twist, &twistReal));
+    Quaternion_fromSwingTwist(&swing, &twist, &result);
+    ASSERT_TRUE("Quaternion_fromSwingTwist of -q", Quaternion_equal(&result, &q));
+
+    // Swing of 180 degrees: the twist is undefined
+    Quaternion_set(0, 0, 1, 0, &q);
+    Quaternion_swingTwist(&q, axis, &swing, &twist);
+    Quaternion_setIdentity(&real);
+    ASSERT_TRUE("Quaternion_swingTwist with undefined twist (twist)", Quaternion_equal(&twist, &real));
+    ASSERT_TRUE("Quaternion_swingTwist with undefined twist (swing)", Quaternion_equal(&swing, &q));
+
+    // Squared axis lengths would overflow or underflow
+    double hugeAxis[3] = {0, 0, 1e300}, tinyAxis[3] = {0, 0, 1e-200};
+    Quaternion_multiply(&swingReal, &twistReal, &q);
+    Quaternion_swingTwist(&q, hugeAxis, &swing, &twist);
+    ASSERT_TRUE("Quaternion_swingTwist with huge axis", Quaternion_equal(&twist, &twistReal));
+    Quaternion_swingTwist(&q, tinyAxis, &swing, &twist);
+    ASSERT_TRUE("Quaternion_swingTwist with tiny axis", Quaternion_equal(&twist, &twistReal));
+
+    // Batch version
+    double w[2], x[2], y[2], z[2], sw[2], sx[2], sy[2], sz[2], tw[2], tx[2], ty[2], tz[2];
+    double ax[2] = {0, 1}, ay[2] = {0, 1}, az[2] = {3, 0};
+    double* axes[3] = {ax, ay, az};
+    QuaternionArray array = {w, {x, y, z}}, swings = {sw, {sx, sy, sz}}, twists = {tw, {tx, ty, tz}};
+    double e[3] = {TO_RAD(30.0), TO_RAD(-20.0), TO_RAD(60.0)};
+    Quaternion_fromEulerZYX(e, &q);
+    Quaternion_store(&q, &array, 0);
+    Quaternion_store(&q, &array, 1);
+    Quaternion_swingTwistArray(&array, axes, 2, &swings, &twists);
+    for(int i = 0; i < 2; i++) {
+        double a[3] = {ax[i], ay[i], az[i]};
+        Quaternion_swingTwist(&q, a, &swingReal, &twistReal);
+        Quaternion_load(&swings, i, &swing);
+        Quaternion_load(&twists, i, &twist);
+        ASSERT_TRUE("Quaternion_swingTwistArray matches Quaternion_swingTwist (swing)", Quaternion_equal(&swing, &swingReal));
+        ASSERT_TRUE("Quaternion_swingTwistArray matches Quaternion_swingTwist (twist)", Quaternion_equal(&twist, &twistReal));
+    }
+}
+
 int main(void)
 {
     testQuaternion_set();
     testQuaternion_setIdentity();
     testQuaternion_copy();
+    testQuaternion_loadStore();
     testQuaternion_equal();
     testQuaternion_conjugate();
     testQuaternion_norm();
@@ -332,5 +727,16 @@ int main(void)
     testQuaternion_multiply();
     testQuaternion_rotate();
     testQuaternion_slerp();
+    testQuaternion_expLog();
+    testQuaternion_pow();
+    testQuaternion_boxplusBoxminus();
+    testQuaternion_expLogArray();
+    testQuaternion_powBoxArray();
+    testQuaternion_rotateArray();
+    testQuaternion_fromTwoVectors();
+    testQuaternion_lookRotation();
+    testQuaternion_fromTwoVectorsArray();
+    testQuaternion_slerpArray();
+    testQuaternion_swingTwist();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,1333 @@
+// TEST: gcc -std=c17 -O3 -fno-math-errno -Wall -Wextra -pthread TestQuaternionAccuracy.c Quaternion.c QuaternionScan.c QuaternionFusion.c QuaternionJoint.c -lm -o TestQuaternionAccuracy.exe; ./TestQuaternionAccuracy.exe
+//
+// Differential accuracy test: every kernel is compared against a long double
+// reference over adversarial input domains. For each kernel and domain the
+// max/mean angular error, the max/mean ULP error and the measured throughput
+// are printed. The program exits with EXIT_FAILURE if any bound is exceeded.
+#include <stdlib.h>
+#include <float.h>
+#include <time.h>
+#include "Quaternion.h"
+#include "QuaternionScan.h"
+#include "QuaternionFusion.h"
+#include "QuaternionJoint.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+
+#define SAMPLE_COUNT 4096
+#define TIMING_REPEATS 64
+#define FUSION_GAIN 0.1
+#define FUSION_INTEGRAL_GAIN 0.05
+#define FUSION_DT 0.01
+
+/**
+ * Quaternion in extended precision, used for the reference calculations.
+ */
+typedef struct LongQuaternion {
+    long double w;
+    long double v[3];
+} LongQuaternion;
+
+typedef enum Domain {
+    DOMAIN_RANDOM,
+    DOMAIN_NEAR_IDENTITY,
+    DOMAIN_ANTIPODAL,
+    DOMAIN_GIMBAL_LOCK,
+    DOMAIN_DENORMAL,
+    DOMAIN_COUNT
+} Domain;
+
+static const char* DOMAIN_NAMES[DOMAIN_COUNT] = {
+    "random", "near-identity", "antipodal", "gimbal-lock", "denormal-norm"
+};
+
+#define DOMAINS_ALL  ((1u << DOMAIN_COUNT) - 1u)
+#define DOMAINS_UNIT (DOMAINS_ALL & ~(1u << DOMAIN_DENORMAL))
+
+/**
+ * Inputs for all kernels of one domain.
+ */
+typedef struct Inputs {
+    Quaternion q1[SAMPLE_COUNT];
+    Quaternion q2[SAMPLE_COUNT];
+    Quaternion scaled[SAMPLE_COUNT];    /**< q1 with a non-unit norm */
+    double t[SAMPLE_COUNT];
+    double v[SAMPLE_COUNT][3];
+    double axis[SAMPLE_COUNT][3];
+    double angle[SAMPLE_COUNT];
+    double euler[SAMPLE_COUNT][3];
+    double rotation[SAMPLE_COUNT][3];   /**< Vector part of log(q1) */
+    double delta[SAMPLE_COUNT][3];      /**< Rotation vector of q2: 2 * log(q2) */
+    double to[SAMPLE_COUNT][3];         /**< v rotated by q1, or nearly opposite to v */
+    double q1Array[4][SAMPLE_COUNT];    /**< q1 as structure of arrays */
+    double q2Array[4][SAMPLE_COUNT];
+    double vArray[3][SAMPLE_COUNT];
+    double rotationArray[3][SAMPLE_COUNT];
+    double deltaArray[3][SAMPLE_COUNT];
+    double toArray[3][SAMPLE_COUNT];
+    double axisArray[3][SAMPLE_COUNT];
+    LongQuaternion prefix[SAMPLE_COUNT];    /**< Sequential product of q1[0] to q1[i] */
+} Inputs;
+
+typedef struct Outputs {
+    Quaternion q[SAMPLE_COUNT];
+    double v[SAMPLE_COUNT][3];
+    double angle[SAMPLE_COUNT];
+    Quaternion twist[SAMPLE_COUNT];
+    double qArray[4][SAMPLE_COUNT];     /**< Outputs of the batch kernels */
+    double vArray[3][SAMPLE_COUNT];
+    double twistArray[4][SAMPLE_COUNT];
+} Outputs;
+
+typedef struct ErrorStats {
+    double maxAngle;
+    double sumAngle;
+    double maxUlp;
+    double sumUlp;
+    size_t count;
+} ErrorStats;
+
+typedef struct Kernel {
+    const char* name;
+    unsigned domains;                   /**< Bit mask of tested domains */
+    void (*run)(Inputs* in, Outputs* out);
+    void (*check)(Inputs* in, Outputs* out, size_t i, ErrorStats* stats);
+    double maxAngle;                    /**< Bound for the angular error in radians */
+    double maxUlp;                      /**< Bound for the ULP error */
+} Kernel;
+
+static Inputs inputs[DOMAIN_COUNT];
+static Outputs outputs;
+static QuaternionFusion fusion;
+static QuaternionJointLimits joints;
+static double jointCone[SAMPLE_COUNT];      /**< Limits of the joints in radians */
+static double jointTwistMin[SAMPLE_COUNT];
+static double jointTwistMax[SAMPLE_COUNT];
+
+
+// ---------------------------------------------------------------------------
+// Random inputs
+// ---------------------------------------------------------------------------
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ull;
+
+static double randomUniform(double lo, double hi)
+{
+    // xorshift64*
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    uint64_t x = rngState * 0x2545F4914F6CDD1Dull;
+    return lo + (hi - lo) * ((double)(x >> 11) * 0x1p-53);
+}
+
+static double randomLog(double lo, double hi)
+{
+    return exp(randomUniform(log(lo), log(hi)));
+}
+
+static double randomSign(void)
+{
+    return randomUniform(0, 1) < 0.5 ? -1.0 : 1.0;
+}
+
+static void randomAxis(double axis[3])
+{
+    double len2;
+    do {
+        axis[0] = randomUniform(-1, 1);
+        axis[1] = randomUniform(-1, 1);
+        axis[2] = randomUniform(-1, 1);
+        len2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    } while(len2 > 1.0 || len2 < 1e-4);
+    double len = sqrt(len2);
+    axis[0] /= len;
+    axis[1] /= len;
+    axis[2] /= len;
+}
+
+static void randomRotation(Quaternion* q)
+{
+    // Uniformly distributed unit quaternion (Shoemake)
+    double u1 = randomUniform(0, 1);
+    double u2 = randomUniform(0, 2 * M_PI);
+    double u3 = randomUniform(0, 2 * M_PI);
+    double a = sqrt(1 - u1);
+    double b = sqrt(u1);
+    Quaternion_set(a * cos(u2), a * sin(u2), b * cos(u3), b * sin(u3), q);
+}
+
+static void axisRotation(double angle, Quaternion* q)
+{
+    double axis[3];
+    randomAxis(axis);
+    Quaternion_fromAxisAngle(axis, angle, q);
+}
+
+static void scale(Quaternion* q, double s, Quaternion* output)
+{
+    Quaternion_set(q->w * s, q->v[0] * s, q->v[1] * s, q->v[2] * s, output);
+}
+
+
+// ---------------------------------------------------------------------------
+// Long double reference
+// ---------------------------------------------------------------------------
+
+static LongQuaternion toLong(Quaternion* q)
+{
+    LongQuaternion r = {q->w, {q->v[0], q->v[1], q->v[2]}};
+    return r;
+}
+
+static LongQuaternion longMultiply(LongQuaternion a, LongQuaternion b)
+{
+    LongQuaternion r;
+    r.w    = a.w*b.w    - a.v[0]*b.v[0] - a.v[1]*b.v[1] - a.v[2]*b.v[2];
+    r.v[0] = a.v[0]*b.w + a.w*b.v[0]    + a.v[1]*b.v[2] - a.v[2]*b.v[1];
+    r.v[1] = a.w*b.v[1] - a.v[0]*b.v[2] + a.v[1]*b.w    + a.v[2]*b.v[0];
+    r.v[2] = a.w*b.v[2] + a.v[0]*b.v[1] - a.v[1]*b.v[0] + a.v[2]*b.w;
+    return r;
+}
+
+static LongQuaternion longNormalize(LongQuaternion q)
+{
+    long double len = sqrtl(q.w*q.w + q.v[0]*q.v[0] + q.v[1]*q.v[1] + q.v[2]*q.v[2]);
+    LongQuaternion r = {q.w / len, {q.v[0] / len, q.v[1] / len, q.v[2] / len}};
+    return r;
+}
+
+static LongQuaternion longFromAxisAngle(long double axis[3], long double angle)
+{
+    long double c = sinl(angle / 2);
+    LongQuaternion r = {cosl(angle / 2), {c * axis[0], c * axis[1], c * axis[2]}};
+    return r;
+}
+
+static LongQuaternion longFromEulerZYX(long double euler[3])
+{
+    long double cy = cosl(euler[2] / 2), sy = sinl(euler[2] / 2);
+    long double cr = cosl(euler[0] / 2), sr = sinl(euler[0] / 2);
+    long double cp = cosl(euler[1] / 2), sp = sinl(euler[1] / 2);
+    LongQuaternion r;
+    r.w    = cy * cr * cp + sy * sr * sp;
+    r.v[0] = cy * sr * cp - sy * cr * sp;
+    r.v[1] = cy * cr * sp + sy * sr * cp;
+    r.v[2] = sy * cr * cp - cy * sr * sp;
+    return r;
+}
+
+static void longRotate(LongQuaternion q, long double v[3], long double output[3])
+{
+    // Same formula as Quaternion_rotate, so non-unit inputs scale identically
+    long double ww = q.w*q.w, xx = q.v[0]*q.v[0], yy = q.v[1]*q.v[1], zz = q.v[2]*q.v[2];
+    long double wx = q.w*q.v[0], wy = q.w*q.v[1], wz = q.w*q.v[2];
+    long double xy = q.v[0]*q.v[1], xz = q.v[0]*q.v[2], yz = q.v[1]*q.v[2];
+    output[0] = (ww + xx - yy - zz)*v[0] + 2*(xy - wz)*v[1] + 2*(xz + wy)*v[2];
+    output[1] = 2*(xy + wz)*v[0] + (ww - xx + yy - zz)*v[1] + 2*(yz - wx)*v[2];
+    output[2] = 2*(xz - wy)*v[0] + 2*(yz + wx)*v[1] + (ww - xx - yy + zz)*v[2];
+}
+
+static LongQuaternion longSlerp(LongQuaternion a, LongQuaternion b, long double t, bool shortestPath)
+{
+    long double cosHalfTheta = a.w*b.w + a.v[0]*b.v[0] + a.v[1]*b.v[1] + a.v[2]*b.v[2];
+    if(shortestPath && cosHalfTheta < 0) {
+        b.w = -b.w;
+        for(int k = 0; k < 3; k++)
+            b.v[k] = -b.v[k];
+    }
+    // Angle from the chord lengths, as acos rounds nearby quaternions to identity
+    long double d = (a.w - b.w)*(a.w - b.w), s = (a.w + b.w)*(a.w + b.w);
+    for(int k = 0; k < 3; k++) {
+        d += (a.v[k] - b.v[k])*(a.v[k] - b.v[k]);
+        s += (a.v[k] + b.v[k])*(a.v[k] + b.v[k]);
+    }
+    if(d == 0 || s == 0)
+        return a;
+    long double halfTheta = 2 * atan2l(sqrtl(d), sqrtl(s));
+    long double sinHalfTheta = sinl(halfTheta);
+    long double ratioA = sinl((1 - t) * halfTheta) / sinHalfTheta;
+    long double ratioB = sinl(t * halfTheta) / sinHalfTheta;
+    LongQuaternion r;
+    r.w = a.w * ratioA + b.w * ratioB;
+    for(int k = 0; k < 3; k++)
+        r.v[k] = a.v[k] * ratioA + b.v[k] * ratioB;
+    return r;
+}
+
+static LongQuaternion longExp(LongQuaternion q)
+{
+    long double len = sqrtl(q.v[0]*q.v[0] + q.v[1]*q.v[1] + q.v[2]*q.v[2]);
+    long double e = expl(q.w);
+    long double c = len > 0 ? e * sinl(len) / len : e;
+    LongQuaternion r = {e * cosl(len), {c * q.v[0], c * q.v[1], c * q.v[2]}};
+    return r;
+}
+
+static LongQuaternion longLog(LongQuaternion q)
+{
+    long double len = sqrtl(q.v[0]*q.v[0] + q.v[1]*q.v[1] + q.v[2]*q.v[2]);
+    long double c = len > 0 ? atan2l(len, q.w) / len : 0;
+    LongQuaternion r = {logl(sqrtl(q.w*q.w + len*len)), {c * q.v[0], c * q.v[1], c * q.v[2]}};
+    // Rotation by 360 degrees: the X-axis, as in Quaternion_log()
+    if(len == 0 && q.w < 0)
+        r.v[0] = M_PI;
+    return r;
+}
+
+/**
+ * Rotation vector of the shortest rotation from b to a: 2 * log(conj(b) * a)
+ */
+static void longBoxminus(LongQuaternion a, LongQuaternion b, long double output[3])
+{
+    LongQuaternion conj = {b.w, {-b.v[0], -b.v[1], -b.v[2]}};
+    LongQuaternion d = longMultiply(conj, a);
+    if(d.w < 0) {
+        d.w = -d.w;
+        for(int k = 0; k < 3; k++)
+            d.v[k] = -d.v[k];
+    }
+    LongQuaternion r = longLog(d);
+    for(int k = 0; k < 3; k++)
+        output[k] = 2 * r.v[k];
+}
+
+/**
+ * Orientation with the Z-axis along forward and the Y-axis towards up,
+ * converted from the rotation matrix with Shepperd's method.
+ */
+static LongQuaternion longLookRotation(long double f[3], long double u[3])
+{
+    long double fl = sqrtl(f[0]*f[0] + f[1]*f[1] + f[2]*f[2]);
+    long double z[3] = {f[0] / fl, f[1] / fl, f[2] / fl};
+    long double x[3] = {u[1]*z[2] - u[2]*z[1], u[2]*z[0] - u[0]*z[2], u[0]*z[1] - u[1]*z[0]};
+    long double xl = sqrtl(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    for(int k = 0; k < 3; k++)
+        x[k] /= xl;
+    long double y[3] = {z[1]*x[2] - z[2]*x[1], z[2]*x[0] - z[0]*x[2], z[0]*x[1] - z[1]*x[0]};
+
+    long double m[3][3] = {{x[0], y[0], z[0]}, {x[1], y[1], z[1]}, {x[2], y[2], z[2]}};
+    long double t = m[0][0] + m[1][1] + m[2][2];
+    LongQuaternion r;
+    if(t >= m[0][0] && t >= m[1][1] && t >= m[2][2]) {
+        long double s = 2 * sqrtl(1 + t);
+        r.w = s / 4;
+        r.v[0] = (m[2][1] - m[1][2]) / s;
+        r.v[1] = (m[0][2] - m[2][0]) / s;
+        r.v[2] = (m[1][0] - m[0][1]) / s;
+    } else if(m[0][0] >= m[1][1] && m[0][0] >= m[2][2]) {
+        long double s = 2 * sqrtl(1 + m[0][0] - m[1][1] - m[2][2]);
+        r.w = (m[2][1] - m[1][2]) / s;
+        r.v[0] = s / 4;
+        r.v[1] = (m[0][1] + m[1][0]) / s;
+        r.v[2] = (m[0][2] + m[2][0]) / s;
+    } else if(m[1][1] >= m[2][2]) {
+        long double s = 2 * sqrtl(1 + m[1][1] - m[0][0] - m[2][2]);
+        r.w = (m[0][2] - m[2][0]) / s;
+        r.v[0] = (m[0][1] + m[1][0]) / s;
+        r.v[1] = s / 4;
+        r.v[2] = (m[1][2] + m[2][1]) / s;
+    } else {
+        long double s = 2 * sqrtl(1 + m[2][2] - m[0][0] - m[1][1]);
+        r.w = (m[1][0] - m[0][1]) / s;
+        r.v[0] = (m[0][2] + m[2][0]) / s;
+        r.v[1] = (m[1][2] + m[2][1]) / s;
+        r.v[2] = s / 4;
+    }
+    return r;
+}
+
+static void longSwingTwist(LongQuaternion q, long double axis[3], LongQuaternion* swing, LongQuaternion* twist)
+{
+    long double a2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    long double p = (q.v[0]*axis[0] + q.v[1]*axis[1] + q.v[2]*axis[2]) / a2;
+    LongQuaternion t = {q.w, {p * axis[0], p * axis[1], p * axis[2]}};
+    long double norm = sqrtl(t.w*t.w + t.v[0]*t.v[0] + t.v[1]*t.v[1] + t.v[2]*t.v[2]);
+    if(q.w < 0)
+        norm = -norm;
+    t.w /= norm;
+    LongQuaternion conj = {t.w, {0, 0, 0}};
+    for(int k = 0; k < 3; k++) {
+        t.v[k] /= norm;
+        conj.v[k] = -t.v[k];
+    }
+    *swing = longMultiply(q, conj);
+    *twist = t;
+}
+
+/**
+ * Normalizes a reading like the filters do, with zero weight for a zero vector.
+ */
+static long double longNormalizeReading(long double v[3])
+{
+    long double n = sqrtl(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    if(n == 0)
+        return 0;
+    for(int k = 0; k < 3; k++)
+        v[k] /= n;
+    return 1;
+}
+
+/**
+ * Earth field (horizontal bx, vertical bz): the reading rotated by q.
+ */
+static void longEarthField(LongQuaternion q, long double m[3], long double* bx, long double* bz)
+{
+    long double h[3];
+    longRotate(q, m, h);
+    *bx = sqrtl(h[0]*h[0] + h[1]*h[1]);
+    *bz = h[2];
+}
+
+/**
+ * One step of Madgwick's filter with magnetometer, written with exact square roots.
+ */
+static LongQuaternion longMadgwick(LongQuaternion q, long double g[3], long double a[3], long double m[3])
+{
+    long double q0 = q.w, q1 = q.v[0], q2 = q.v[1], q3 = q.v[2];
+    long double aValid = longNormalizeReading(a);
+    long double mValid = longNormalizeReading(m);
+    long double bx, bz;
+    longEarthField(q, m, &bx, &bz);
+
+    long double f[6] = {
+        2*(q1*q3 - q0*q2) - a[0],
+        2*(q0*q1 + q2*q3) - a[1],
+        2*(0.5L - q1*q1 - q2*q2) - a[2],
+        2*bx*(0.5L - q2*q2 - q3*q3) + 2*bz*(q1*q3 - q0*q2) - m[0],
+        2*bx*(q1*q2 - q0*q3) + 2*bz*(q0*q1 + q2*q3) - m[1],
+        2*bx*(q0*q2 + q1*q3) + 2*bz*(0.5L - q1*q1 - q2*q2) - m[2]
+    };
+    // Jacobian of f, row by row
+    long double j[6][4] = {
+        {-2*q2, 2*q3, -2*q0, 2*q1},
+        {2*q1, 2*q0, 2*q3, 2*q2},
+        {0, -4*q1, -4*q2, 0},
+        {-2*bz*q2, 2*bz*q3, -4*bx*q2 - 2*bz*q0, -4*bx*q3 + 2*bz*q1},
+        {-2*bx*q3 + 2*bz*q1, 2*bx*q2 + 2*bz*q0, 2*bx*q1 + 2*bz*q3, -2*bx*q0 + 2*bz*q2},
+        {2*bx*q2, 2*bx*q3 - 4*bz*q1, 2*bx*q0 - 4*bz*q2, 2*bx*q1}
+    };
+    long double s[4] = {0}, s2 = 0;
+    for(int c = 0; c < 4; c++) {
+        for(int r = 0; r < 6; r++)
+            s[c] += ((r < 3) ? aValid : mValid) * j[r][c] * f[r];
+        s2 += s[c] * s[c];
+    }
+
+    LongQuaternion omega = {0, {g[0], g[1], g[2]}};
+    LongQuaternion qDot = longMultiply(q, omega);
+    long double step = aValid * FUSION_GAIN / sqrtl(s2);
+    LongQuaternion r = {
+        q0 + (qDot.w / 2 - step * s[0]) * FUSION_DT,
+        {q1 + (qDot.v[0] / 2 - step * s[1]) * FUSION_DT,
+         q2 + (qDot.v[1] / 2 - step * s[2]) * FUSION_DT,
+         q3 + (qDot.v[2] / 2 - step * s[3]) * FUSION_DT}
+    };
+    return longNormalize(r);
+}
+
+/**
+ * One step of Mahony's filter with magnetometer, starting without integrated error.
+ */
+static LongQuaternion longMahony(LongQuaternion q, long double g[3], long double a[3], long double m[3])
+{
+    long double aValid = longNormalizeReading(a);
+    long double mValid = longNormalizeReading(m);
+    long double bx, bz;
+    longEarthField(q, m, &bx, &bz);
+
+    // Gravity and earth field in sensor frame: rotated by conj(q)
+    LongQuaternion conj = {q.w, {-q.v[0], -q.v[1], -q.v[2]}};
+    long double up[3] = {0, 0, 1}, field[3] = {bx, 0, bz}, v[3], w[3];
+    longRotate(conj, up, v);
+    longRotate(conj, field, w);
+
+    long double e[3], ki = FUSION_INTEGRAL_GAIN * FUSION_DT;
+    for(int k = 0; k < 3; k++) {
+        int k1 = (k + 1) % 3, k2 = (k + 2) % 3;
+        e[k] = aValid * ((a[k1]*v[k2] - a[k2]*v[k1]) + mValid * (m[k1]*w[k2] - m[k2]*w[k1]));
+    }
+    LongQuaternion omega = {0, {0, 0, 0}};
+    for(int k = 0; k < 3; k++)
+        omega.v[k] = g[k] + FUSION_GAIN * e[k] + ki * e[k];
+    LongQuaternion qDot = longMultiply(q, omega);
+    LongQuaternion r = {q.w + qDot.w * FUSION_DT / 2, {0, 0, 0}};
+    for(int k = 0; k < 3; k++)
+        r.v[k] = q.v[k] + qDot.v[k] * FUSION_DT / 2;
+    return longNormalize(r);
+}
+
+/**
+ * Joint limit by angles: the swing angle is clamped to the cone and the twist
+ * angle to the range, then both are combined again.
+ */
+static LongQuaternion longClampJoint(LongQuaternion q, long double axis[3], long double cone,
+    long double twistMin, long double twistMax)
+{
+    LongQuaternion swing, twist;
+    longSwingTwist(q, axis, &swing, &twist);
+
+    long double twistSin = twist.v[0]*axis[0] + twist.v[1]*axis[1] + twist.v[2]*axis[2];
+    long double twistAngle = 2 * atan2l(twistSin, twist.w);
+    twistAngle = fminl(fmaxl(twistAngle, twistMin), twistMax);
+    twist = longFromAxisAngle(axis, twistAngle);
+
+    if(swing.w < 0) {
+        swing.w = -swing.w;
+        for(int k = 0; k < 3; k++)
+            swing.v[k] = -swing.v[k];
+    }
+    long double len = sqrtl(swing.v[0]*swing.v[0] + swing.v[1]*swing.v[1] + swing.v[2]*swing.v[2]);
+    long double swingAngle = 2 * atan2l(len, swing.w);
+    if(swingAngle > cone && len > 0) {
+        long double swingAxis[3] = {swing.v[0] / len, swing.v[1] / len, swing.v[2] / len};
+        swing = longFromAxisAngle(swingAxis, cone);
+    }
+
+    LongQuaternion r = longMultiply(swing, twist);
+    if(r.w*q.w + r.v[0]*q.v[0] + r.v[1]*q.v[1] + r.v[2]*q.v[2] < 0) {
+        r.w = -r.w;
+        for(int k = 0; k < 3; k++)
+            r.v[k] = -r.v[k];
+    }
+    return r;
+}
+
+
+// ---------------------------------------------------------------------------
+// Error measures
+// ---------------------------------------------------------------------------
+
+static void record(ErrorStats* stats, long double angle, double ulp)
+{
+    // NaN or infinity must never pass a bound
+    if(isnan(angle) || isinf(angle))
+        angle = INFINITY;
+    if(isnan(ulp) || isinf(ulp))
+        ulp = INFINITY;
+    stats->maxAngle = fmax(stats->maxAngle, (double)angle);
+    stats->maxUlp = fmax(stats->maxUlp, ulp);
+    stats->sumAngle += (double)angle;
+    stats->sumUlp += ulp;
+    stats->count++;
+}
+
+/**
+ * Largest component error in units of the last place of the largest
+ * reference component.
+ */
+static double ulpError(long double* x, long double* ref, int n)
+{
+    long double magnitude = 0;
+    for(int k = 0; k < n; k++)
+        magnitude = fmaxl(magnitude, fabsl(ref[k]));
+    double m = (double)magnitude;
+    double ulp = nextafter(m, INFINITY) - m;
+
+    long double maxError = 0;
+    for(int k = 0; k < n; k++)
+        maxError = fmaxl(maxError, fabsl(x[k] - ref[k]));
+    return (double)(maxError / ulp);
+}
+
+/**
+ * Rotation angle between two quaternions, independent of norm and sign.
+ */
+static long double quaternionAngle(LongQuaternion q, LongQuaternion ref)
+{
+    // conj(ref) * q
+    long double w = ref.w*q.w + ref.v[0]*q.v[0] + ref.v[1]*q.v[1] + ref.v[2]*q.v[2];
+    long double x = ref.w*q.v[0] - q.w*ref.v[0] - (ref.v[1]*q.v[2] - ref.v[2]*q.v[1]);
+    long double y = ref.w*q.v[1] - q.w*ref.v[1] - (ref.v[2]*q.v[0] - ref.v[0]*q.v[2]);
+    long double z = ref.w*q.v[2] - q.w*ref.v[2] - (ref.v[0]*q.v[1] - ref.v[1]*q.v[0]);
+    return 2 * atan2l(sqrtl(x*x + y*y + z*z), fabsl(w));
+}
+
+static void quaternionError(Quaternion* q, LongQuaternion ref, ErrorStats* stats)
+{
+    LongQuaternion lq = toLong(q);
+    record(stats, quaternionAngle(lq, ref), ulpError(&lq.w, &ref.w, 4));
+}
+
+static void vectorError(double v[3], long double ref[3], ErrorStats* stats)
+{
+    long double x[3] = {v[0], v[1], v[2]};
+    long double c0 = x[1]*ref[2] - x[2]*ref[1];
+    long double c1 = x[2]*ref[0] - x[0]*ref[2];
+    long double c2 = x[0]*ref[1] - x[1]*ref[0];
+    long double d = x[0]*ref[0] + x[1]*ref[1] + x[2]*ref[2];
+    record(stats, atan2l(sqrtl(c0*c0 + c1*c1 + c2*c2), d), ulpError(x, ref, 3));
+}
+
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+static void runMultiply(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_multiply(&in->q1[i], &in->q2[i], &out->q[i]);
+}
+
+static void checkMultiply(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    quaternionError(&out->q[i], longMultiply(toLong(&in->q1[i]), toLong(&in->q2[i])), stats);
+}
+
+static void runRotate(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_rotate(&in->q1[i], in->v[i], out->v[i]);
+}
+
+static void checkRotate(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double v[3] = {in->v[i][0], in->v[i][1], in->v[i][2]};
+    long double ref[3];
+    longRotate(toLong(&in->q1[i]), v, ref);
+    vectorError(out->v[i], ref, stats);
+}
+
+static void runNormalize(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_normalize(&in->scaled[i], &out->q[i]);
+}
+
+static void checkNormalize(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    quaternionError(&out->q[i], longNormalize(toLong(&in->scaled[i])), stats);
+}
+
+static void runNormalizeFast(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_normalizeFast(&in->scaled[i], &out->q[i]);
+}
+
+static void runFromAxisAngle(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_fromAxisAngle(in->axis[i], in->angle[i], &out->q[i]);
+}
+
+static void checkFromAxisAngle(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double axis[3] = {in->axis[i][0], in->axis[i][1], in->axis[i][2]};
+    quaternionError(&out->q[i], longFromAxisAngle(axis, in->angle[i]), stats);
+}
+
+static void runToAxisAngle(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        out->angle[i] = Quaternion_toAxisAngle(&in->q1[i], out->v[i]);
+}
+
+static void checkToAxisAngle(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    // Angle: rotation between the input and the reconstructed quaternion
+    // ULP: error of the rotation vector (axis * angle)
+    LongQuaternion q = toLong(&in->q1[i]);
+    long double axis[3] = {out->v[i][0], out->v[i][1], out->v[i][2]};
+    LongQuaternion r = longFromAxisAngle(axis, out->angle[i]);
+
+    long double vlen = sqrtl(q.v[0]*q.v[0] + q.v[1]*q.v[1] + q.v[2]*q.v[2]);
+    long double refAngle = 2 * atan2l(vlen, q.w);
+    long double ref[3], x[3];
+    for(int k = 0; k < 3; k++) {
+        ref[k] = vlen > 0 ? q.v[k] / vlen * refAngle : 0;
+        x[k] = axis[k] * out->angle[i];
+    }
+    record(stats, quaternionAngle(r, q), ulpError(x, ref, 3));
+}
+
+static void runFromEulerZYX(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_fromEulerZYX(in->euler[i], &out->q[i]);
+}
+
+static void checkFromEulerZYX(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double euler[3] = {in->euler[i][0], in->euler[i][1], in->euler[i][2]};
+    quaternionError(&out->q[i], longFromEulerZYX(euler), stats);
+}
+
+static void runToEulerZYX(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_toEulerZYX(&in->q1[i], out->v[i]);
+}
+
+static void checkToEulerZYX(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    // Euler angles are ambiguous at gimbal lock: compare the reconstruction
+    long double euler[3] = {out->v[i][0], out->v[i][1], out->v[i][2]};
+    LongQuaternion q = toLong(&in->q1[i]);
+    LongQuaternion r = longFromEulerZYX(euler);
+    if(r.w*q.w + r.v[0]*q.v[0] + r.v[1]*q.v[1] + r.v[2]*q.v[2] < 0) {
+        r.w = -r.w;
+        r.v[0] = -r.v[0];
+        r.v[1] = -r.v[1];
+        r.v[2] = -r.v[2];
+    }
+    record(stats, quaternionAngle(r, q), ulpError(&r.w, &q.w, 4));
+}
+
+static void runSlerp(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_slerp(&in->q1[i], &in->q2[i], in->t[i], &out->q[i]);
+}
+
+static void checkSlerp(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    quaternionError(&out->q[i], longSlerp(toLong(&in->q1[i]), toLong(&in->q2[i]), in->t[i], false), stats);
+}
+
+static void runExp(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++) {
+        Quaternion q = {0, {in->rotation[i][0], in->rotation[i][1], in->rotation[i][2]}};
+        Quaternion_exp(&q, &out->q[i]);
+    }
+}
+
+static void checkExp(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    LongQuaternion q = {0, {in->rotation[i][0], in->rotation[i][1], in->rotation[i][2]}};
+    quaternionError(&out->q[i], longExp(q), stats);
+}
+
+static void runLog(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++) {
+        Quaternion q;
+        Quaternion_log(&in->q1[i], &q);
+        for(int k = 0; k < 3; k++)
+            out->v[i][k] = q.v[k];
+    }
+}
+
+static void checkLog(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    LongQuaternion r = longLog(toLong(&in->q1[i]));
+    vectorError(out->v[i], r.v, stats);
+}
+
+static void runPow(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_pow(&in->q1[i], in->t[i], &out->q[i]);
+}
+
+static void checkPow(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    LongQuaternion r = longLog(toLong(&in->q1[i]));
+    r.w *= in->t[i];
+    for(int k = 0; k < 3; k++)
+        r.v[k] *= in->t[i];
+    quaternionError(&out->q[i], longExp(r), stats);
+}
+
+static void runBoxplus(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_boxplus(&in->q1[i], in->delta[i], &out->q[i]);
+}
+
+static void checkBoxplus(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    LongQuaternion d = {0, {in->delta[i][0] / 2, in->delta[i][1] / 2, in->delta[i][2] / 2}};
+    quaternionError(&out->q[i], longMultiply(toLong(&in->q1[i]), longExp(d)), stats);
+}
+
+static void runBoxminus(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_boxminus(&in->q1[i], &in->q2[i], out->v[i]);
+}
+
+static void checkBoxminus(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    // Angle: rotation between q1 and the reconstruction boxplus(q2, output),
+    // as the direction of a tiny difference is ill-conditioned
+    // ULP: error of the rotation vector
+    long double ref[3], x[3] = {out->v[i][0], out->v[i][1], out->v[i][2]};
+    longBoxminus(toLong(&in->q1[i]), toLong(&in->q2[i]), ref);
+    LongQuaternion d = {0, {x[0] / 2, x[1] / 2, x[2] / 2}};
+    LongQuaternion r = longMultiply(toLong(&in->q2[i]), longExp(d));
+    record(stats, quaternionAngle(r, toLong(&in->q1[i])), ulpError(x, ref, 3));
+}
+
+// Batch kernels write structures of arrays, copied back for the checks
+
+static QuaternionArray toArray(double array[4][SAMPLE_COUNT])
+{
+    QuaternionArray a = {array[0], {array[1], array[2], array[3]}};
+    return a;
+}
+
+static void loadQuaternion(Outputs* out, size_t i)
+{
+    QuaternionArray a = toArray(out->qArray);
+    Quaternion_load(&a, i, &out->q[i]);
+}
+
+static void loadVector(Outputs* out, size_t i)
+{
+    for(int k = 0; k < 3; k++)
+        out->v[i][k] = out->vArray[k][i];
+}
+
+static void runExpArray(Inputs* in, Outputs* out)
+{
+    double* v[3] = {in->rotationArray[0], in->rotationArray[1], in->rotationArray[2]};
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_expArray(v, SAMPLE_COUNT, &output);
+}
+
+static void checkExpArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    checkExp(in, out, i, stats);
+}
+
+static void runLogArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    double* output[3] = {out->vArray[0], out->vArray[1], out->vArray[2]};
+    Quaternion_logArray(&q, SAMPLE_COUNT, output);
+}
+
+static void checkLogArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadVector(out, i);
+    checkLog(in, out, i, stats);
+}
+
+static void runPowArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_powArray(&q, in->t, SAMPLE_COUNT, &output);
+}
+
+static void checkPowArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    checkPow(in, out, i, stats);
+}
+
+static void runBoxplusArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    double* delta[3] = {in->deltaArray[0], in->deltaArray[1], in->deltaArray[2]};
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_boxplusArray(&q, delta, SAMPLE_COUNT, &output);
+}
+
+static void checkBoxplusArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    checkBoxplus(in, out, i, stats);
+}
+
+static void runBoxminusArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q1 = toArray(in->q1Array);
+    QuaternionArray q2 = toArray(in->q2Array);
+    double* output[3] = {out->vArray[0], out->vArray[1], out->vArray[2]};
+    Quaternion_boxminusArray(&q1, &q2, SAMPLE_COUNT, output);
+}
+
+static void checkBoxminusArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadVector(out, i);
+    checkBoxminus(in, out, i, stats);
+}
+
+static void runRotateArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    double* v[3] = {in->vArray[0], in->vArray[1], in->vArray[2]};
+    double* output[3] = {out->vArray[0], out->vArray[1], out->vArray[2]};
+    Quaternion_rotateArray(&q, v, SAMPLE_COUNT, output);
+}
+
+static void checkRotateArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadVector(out, i);
+    checkRotate(in, out, i, stats);
+}
+
+static void runFromTwoVectors(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_fromTwoVectors(in->v[i], in->to[i], &out->q[i]);
+}
+
+static void checkFromTwoVectors(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    // The rotation axis of nearly opposite vectors is ill-conditioned:
+    // check that v is rotated onto the direction of to instead
+    long double v[3] = {in->v[i][0], in->v[i][1], in->v[i][2]};
+    long double to[3] = {in->to[i][0], in->to[i][1], in->to[i][2]};
+    long double r[3];
+    LongQuaternion q = longNormalize(toLong(&out->q[i]));
+    longRotate(q, v, r);
+    long double scale = sqrtl((to[0]*to[0] + to[1]*to[1] + to[2]*to[2]) / (v[0]*v[0] + v[1]*v[1] + v[2]*v[2]));
+    double x[3];
+    for(int k = 0; k < 3; k++)
+        x[k] = (double)(r[k] * scale);
+    vectorError(x, to, stats);
+}
+
+static void runLookRotation(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_lookRotation(in->v[i], in->axis[i], &out->q[i]);
+}
+
+static void checkLookRotation(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double f[3] = {in->v[i][0], in->v[i][1], in->v[i][2]};
+    long double u[3] = {in->axis[i][0], in->axis[i][1], in->axis[i][2]};
+    LongQuaternion ref = longLookRotation(f, u);
+    if(ref.w*out->q[i].w + ref.v[0]*out->q[i].v[0] + ref.v[1]*out->q[i].v[1] + ref.v[2]*out->q[i].v[2] < 0) {
+        ref.w = -ref.w;
+        for(int k = 0; k < 3; k++)
+            ref.v[k] = -ref.v[k];
+    }
+    quaternionError(&out->q[i], ref, stats);
+}
+
+static void runFromTwoVectorsArray(Inputs* in, Outputs* out)
+{
+    double* from[3] = {in->vArray[0], in->vArray[1], in->vArray[2]};
+    double* to[3] = {in->toArray[0], in->toArray[1], in->toArray[2]};
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_fromTwoVectorsArray(from, to, SAMPLE_COUNT, &output);
+}
+
+static void checkFromTwoVectorsArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    checkFromTwoVectors(in, out, i, stats);
+}
+
+static void runLookRotationArray(Inputs* in, Outputs* out)
+{
+    double* forward[3] = {in->vArray[0], in->vArray[1], in->vArray[2]};
+    double* up[3] = {in->axisArray[0], in->axisArray[1], in->axisArray[2]};
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_lookRotationArray(forward, up, SAMPLE_COUNT, &output);
+}
+
+static void checkLookRotationArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    checkLookRotation(in, out, i, stats);
+}
+
+static void runSlerpArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q1 = toArray(in->q1Array);
+    QuaternionArray q2 = toArray(in->q2Array);
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_slerpArray(&q1, &q2, in->t, SAMPLE_COUNT, false, &output);
+}
+
+static void checkSlerpArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    quaternionError(&out->q[i], longSlerp(toLong(&in->q1[i]), toLong(&in->q2[i]), in->t[i], false), stats);
+}
+
+static void runSlerpArrayShortest(Inputs* in, Outputs* out)
+{
+    QuaternionArray q1 = toArray(in->q1Array);
+    QuaternionArray q2 = toArray(in->q2Array);
+    QuaternionArray output = toArray(out->qArray);
+    Quaternion_slerpArray(&q1, &q2, in->t, SAMPLE_COUNT, true, &output);
+}
+
+static void checkSlerpArrayShortest(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    quaternionError(&out->q[i], longSlerp(toLong(&in->q1[i]), toLong(&in->q2[i]), in->t[i], true), stats);
+}
+
+static void runSwingTwist(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_swingTwist(&in->q1[i], in->axis[i], &out->q[i], &out->twist[i]);
+}
+
+static void checkSwingTwist(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double axis[3] = {in->axis[i][0], in->axis[i][1], in->axis[i][2]};
+    LongQuaternion swing, twist;
+    longSwingTwist(toLong(&in->q1[i]), axis, &swing, &twist);
+    quaternionError(&out->q[i], swing, stats);
+    quaternionError(&out->twist[i], twist, stats);
+}
+
+static void runSwingTwistArray(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    double* axis[3] = {in->axisArray[0], in->axisArray[1], in->axisArray[2]};
+    QuaternionArray swing = toArray(out->qArray);
+    QuaternionArray twist = toArray(out->twistArray);
+    Quaternion_swingTwistArray(&q, axis, SAMPLE_COUNT, &swing, &twist);
+}
+
+static void checkSwingTwistArray(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    QuaternionArray twist = toArray(out->twistArray);
+    loadQuaternion(out, i);
+    Quaternion_load(&twist, i, &out->twist[i]);
+    checkSwingTwist(in, out, i, stats);
+}
+
+/**
+ * Starts the filters at q1, without integrated error
+ */
+static void resetFusion(Inputs* in)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++) {
+        fusion.orientation.w[i] = in->q1Array[0][i];
+        for(int k = 0; k < 3; k++) {
+            fusion.orientation.v[k][i] = in->q1Array[k + 1][i];
+            fusion.integralError[k][i] = 0;
+        }
+    }
+}
+
+// Gyroscope v, accelerometer to and magnetometer axis
+static void runMadgwick(Inputs* in, Outputs* out)
+{
+    (void)out;
+    double* gyro[3] = {in->vArray[0], in->vArray[1], in->vArray[2]};
+    double* accel[3] = {in->toArray[0], in->toArray[1], in->toArray[2]};
+    double* mag[3] = {in->axisArray[0], in->axisArray[1], in->axisArray[2]};
+    resetFusion(in);
+    QuaternionFusion_updateMadgwick(&fusion, gyro, accel, mag, FUSION_DT);
+}
+
+static void checkMadgwick(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double g[3], a[3], m[3];
+    for(int k = 0; k < 3; k++) {
+        g[k] = in->v[i][k];
+        a[k] = in->to[i][k];
+        m[k] = in->axis[i][k];
+    }
+    Quaternion_load(&fusion.orientation, i, &out->q[i]);
+    quaternionError(&out->q[i], longMadgwick(toLong(&in->q1[i]), g, a, m), stats);
+}
+
+static void runMahony(Inputs* in, Outputs* out)
+{
+    (void)out;
+    double* gyro[3] = {in->vArray[0], in->vArray[1], in->vArray[2]};
+    double* accel[3] = {in->toArray[0], in->toArray[1], in->toArray[2]};
+    double* mag[3] = {in->axisArray[0], in->axisArray[1], in->axisArray[2]};
+    resetFusion(in);
+    QuaternionFusion_updateMahony(&fusion, gyro, accel, mag, FUSION_DT);
+}
+
+static void checkMahony(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double g[3], a[3], m[3];
+    for(int k = 0; k < 3; k++) {
+        g[k] = in->v[i][k];
+        a[k] = in->to[i][k];
+        m[k] = in->axis[i][k];
+    }
+    Quaternion_load(&fusion.orientation, i, &out->q[i]);
+    quaternionError(&out->q[i], longMahony(toLong(&in->q1[i]), g, a, m), stats);
+}
+
+static void runFromSwingTwist(Inputs* in, Outputs* out)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        Quaternion_fromSwingTwist(&in->q1[i], &in->q2[i], &out->q[i]);
+}
+
+static void checkFromSwingTwist(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    quaternionError(&out->q[i], longMultiply(toLong(&in->q1[i]), toLong(&in->q2[i])), stats);
+}
+
+static void runClampJoints(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    QuaternionArray output = toArray(out->qArray);
+    QuaternionJointLimits_clamp(&joints, &q, &output);
+}
+
+static void checkClampJoints(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    long double axis[3] = {joints.axis[0][i], joints.axis[1][i], joints.axis[2][i]};
+    loadQuaternion(out, i);
+    quaternionError(&out->q[i], longClampJoint(toLong(&in->q1[i]), axis,
+        jointCone[i], jointTwistMin[i], jointTwistMax[i]), stats);
+}
+
+// Blocks of 256 elements on 4 threads exercise all steps of the blocked scan
+static const QuaternionScanOptions scanOptions = {QUATERNION_SCAN_RIGHT, 4, 256, false};
+
+static void runScanInclusive(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    QuaternionArray output = toArray(out->qArray);
+    QuaternionScan_inclusive(&q, SAMPLE_COUNT, &scanOptions, &output);
+}
+
+static void checkScanInclusive(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    loadQuaternion(out, i);
+    quaternionError(&out->q[i], in->prefix[i], stats);
+}
+
+static void runScanReduce(Inputs* in, Outputs* out)
+{
+    QuaternionArray q = toArray(in->q1Array);
+    QuaternionScan_reduce(&q, SAMPLE_COUNT, &scanOptions, &out->q[0]);
+}
+
+static void checkScanReduce(Inputs* in, Outputs* out, size_t i, ErrorStats* stats)
+{
+    if(i == SAMPLE_COUNT - 1)
+        quaternionError(&out->q[0], in->prefix[i], stats);
+}
+
+static Kernel kernels[] = {
+    // name                       domains       run               check               maxAngle  maxUlp
+    {"Quaternion_multiply",       DOMAINS_UNIT, runMultiply,      checkMultiply,      1e-15,    8},
+    {"Quaternion_rotate",         DOMAINS_UNIT, runRotate,        checkRotate,        1e-15,    16},
+    {"Quaternion_normalize",      DOMAINS_ALL,  runNormalize,     checkNormalize,     1e-15,    4},
+    {"Quaternion_normalizeFast",  DOMAINS_UNIT, runNormalizeFast, checkNormalize,     1e-15,    1e6},
+    {"Quaternion_fromAxisAngle",  DOMAINS_UNIT, runFromAxisAngle, checkFromAxisAngle, 1e-15,    4},
+    {"Quaternion_fromEulerZYX",   DOMAINS_UNIT, runFromEulerZYX,  checkFromEulerZYX,  1e-15,    8},
+    // acos/asin lose half of the digits near identity and gimbal lock
+    {"Quaternion_toAxisAngle",    DOMAINS_UNIT, runToAxisAngle,   checkToAxisAngle,   1e-7,     INFINITY},
+    {"Quaternion_toEulerZYX",     DOMAINS_UNIT, runToEulerZYX,    checkToEulerZYX,    1e-7,     INFINITY},
+    // Falls back to the midpoint if both inputs are closer than QUATERNION_EPS
+    {"Quaternion_slerp",          DOMAINS_UNIT, runSlerp,         checkSlerp,         2 * QUATERNION_EPS, INFINITY},
+    // Rounding of the rotation angle adds a few ULP to exp, pow and boxplus
+    {"Quaternion_exp",            DOMAINS_UNIT, runExp,           checkExp,           4e-15,    8},
+    {"Quaternion_log",            DOMAINS_UNIT, runLog,           checkLog,           1e-15,    8},
+    {"Quaternion_pow",            DOMAINS_UNIT, runPow,           checkPow,           4e-15,    16},
+    {"Quaternion_boxplus",        DOMAINS_UNIT, runBoxplus,       checkBoxplus,       4e-15,    16},
+    // The difference of nearby rotations cancels: only the reconstruction is bounded
+    {"Quaternion_boxminus",       DOMAINS_UNIT, runBoxminus,      checkBoxminus,      4e-15,    INFINITY},
+    {"Quaternion_expArray",       DOMAINS_UNIT, runExpArray,      checkExpArray,      4e-15,    8},
+    {"Quaternion_logArray",       DOMAINS_UNIT, runLogArray,      checkLogArray,      1e-15,    8},
+    {"Quaternion_powArray",       DOMAINS_UNIT, runPowArray,      checkPowArray,      4e-15,    16},
+    {"Quaternion_boxplusArray",   DOMAINS_UNIT, runBoxplusArray,  checkBoxplusArray,  4e-15,    16},
+    {"Quaternion_boxminusArray",  DOMAINS_UNIT, runBoxminusArray, checkBoxminusArray, 4e-15,    INFINITY},
+    {"Quaternion_rotateArray",    DOMAINS_UNIT, runRotateArray,   checkRotateArray,   1e-15,    16},
+    {"Quaternion_fromTwoVectors", DOMAINS_UNIT, runFromTwoVectors, checkFromTwoVectors, 1e-15,  16},
+    {"Quaternion_lookRotation",   DOMAINS_UNIT, runLookRotation,  checkLookRotation,  4e-15,    16},
+    {"Quaternion_fromTwoVectorsArray", DOMAINS_UNIT, runFromTwoVectorsArray, checkFromTwoVectorsArray, 1e-15, 16},
+    {"Quaternion_lookRotationArray", DOMAINS_UNIT, runLookRotationArray, checkLookRotationArray, 4e-15, 16},
+    // The long arc between nearly opposite quaternions is ill-conditioned
+    {"Quaternion_slerpArray",     DOMAINS_UNIT, runSlerpArray,    checkSlerpArray,    1e-12,    INFINITY},
+    {"Quaternion_slerpArray (shortest)", DOMAINS_UNIT, runSlerpArrayShortest, checkSlerpArrayShortest, 4e-15, 16},
+    {"Quaternion_swingTwist",     DOMAINS_UNIT, runSwingTwist,    checkSwingTwist,    4e-15,    16},
+    {"Quaternion_swingTwistArray", DOMAINS_UNIT, runSwingTwistArray, checkSwingTwistArray, 4e-15, 16},
+    {"Quaternion_fromSwingTwist", DOMAINS_UNIT, runFromSwingTwist, checkFromSwingTwist, 1e-15,  8},
+    {"QuaternionJointLimits_clamp", DOMAINS_UNIT, runClampJoints, checkClampJoints,   4e-15,    16},
+    // Rounding errors of the 4096 factors accumulate (drift): the bound is
+    // about sqrt(4096) times the error of a single product
+    {"QuaternionScan_inclusive",  DOMAINS_UNIT, runScanInclusive, checkScanInclusive, 64 * 1e-15, 64 * 8},
+    {"QuaternionScan_reduce",     DOMAINS_UNIT, runScanReduce,    checkScanReduce,    64 * 1e-15, 64 * 8},
+    // Readings, gradient and result are normalized with Quaternion_fastInverseSqrt()
+    // (relative error below 1e-10), which enters the correction of gain * dt = 1e-3
+    {"QuaternionFusion_updateMadgwick", DOMAINS_UNIT, runMadgwick, checkMadgwick, 1e-11, 1e6},
+    {"QuaternionFusion_updateMahony", DOMAINS_UNIT, runMahony,    checkMahony,        1e-11,    1e6},
+};
+
+
+// ---------------------------------------------------------------------------
+// Domains
+// ---------------------------------------------------------------------------
+
+static void fillInputs(Domain domain, Inputs* in)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++) {
+        in->t[i] = randomUniform(0, 1);
+        for(int k = 0; k < 3; k++)
+            in->v[i][k] = randomUniform(-10, 10);
+        randomAxis(in->axis[i]);
+        in->angle[i] = randomUniform(-2 * M_PI, 2 * M_PI);
+        in->euler[i][0] = randomUniform(-M_PI, M_PI);
+        in->euler[i][1] = randomUniform(-M_PI / 2, M_PI / 2);
+        in->euler[i][2] = randomUniform(-M_PI, M_PI);
+        randomRotation(&in->q1[i]);
+        randomRotation(&in->q2[i]);
+
+        Quaternion delta;
+        switch(domain) {
+        case DOMAIN_NEAR_IDENTITY:
+            axisRotation(randomSign() * randomLog(1e-12, 1e-3), &in->q1[i]);
+            axisRotation(randomLog(1e-12, 1e-3), &delta);
+            Quaternion_multiply(&in->q1[i], &delta, &in->q2[i]);
+            in->angle[i] = randomSign() * randomLog(1e-12, 1e-3);
+            for(int k = 0; k < 3; k++)
+                in->euler[i][k] = randomSign() * randomLog(1e-12, 1e-3);
+            break;
+        case DOMAIN_ANTIPODAL:
+            // Rotations close to 180 and exactly or close to 360 degrees, q2 close to -q1
+            if(i % 2 == 0) {
+                axisRotation(M_PI + randomSign() * randomLog(1e-12, 1e-1), &in->q1[i]);
+                in->angle[i] = randomSign() * (M_PI - randomLog(1e-12, 1e-1));
+            } else {
+                axisRotation(2 * M_PI - randomLog(1e-12, 1e-1), &in->q1[i]);
+                in->angle[i] = randomSign() * (2 * M_PI - randomLog(1e-12, 1e-1));
+                if(i % 16 == 1)
+                    Quaternion_set(-1, 0, 0, 0, &in->q1[i]);
+            }
+            axisRotation(randomLog(2e-3, 2e-1), &delta);
+            Quaternion_multiply(&in->q1[i], &delta, &in->q2[i]);
+            scale(&in->q2[i], -1, &in->q2[i]);
+            in->euler[i][0] = randomSign() * (M_PI - randomLog(1e-12, 1e-1));
+            in->euler[i][2] = randomSign() * (M_PI - randomLog(1e-12, 1e-1));
+            break;
+        case DOMAIN_GIMBAL_LOCK: {
+            double offset = (i % 8 == 0) ? 0 : randomLog(1e-12, 1e-3);
+            in->euler[i][1] = randomSign() * (M_PI / 2 - offset);
+            long double euler[3] = {in->euler[i][0], in->euler[i][1], in->euler[i][2]};
+            LongQuaternion q = longFromEulerZYX(euler);
+            Quaternion_set(q.w, q.v[0], q.v[1], q.v[2], &in->q1[i]);
+            break;
+        }
+        default:
+            break;
+        }
+
+        if(domain == DOMAIN_DENORMAL)
+            scale(&in->q1[i], pow(10, randomUniform(-322, -300)), &in->scaled[i]);
+        else
+            scale(&in->q1[i], randomLog(1e-3, 1e3), &in->scaled[i]);
+
+        LongQuaternion r1 = longLog(toLong(&in->q1[i]));
+        LongQuaternion r2 = longLog(toLong(&in->q2[i]));
+        for(int k = 0; k < 3; k++) {
+            in->rotation[i][k] = (double)r1.v[k];
+            in->delta[i][k] = (double)(2 * r2.v[k]);
+            in->vArray[k][i] = in->v[i][k];
+            in->axisArray[k][i] = in->axis[i][k];
+            in->rotationArray[k][i] = in->rotation[i][k];
+            in->deltaArray[k][i] = in->delta[i][k];
+        }
+        if(domain == DOMAIN_ANTIPODAL) {
+            // Nearly or exactly opposite directions
+            axisRotation((i % 8 == 0) ? 0 : randomLog(1e-12, 1e-1), &delta);
+            Quaternion_rotate(&delta, in->v[i], in->to[i]);
+            for(int k = 0; k < 3; k++)
+                in->to[i][k] = -in->to[i][k];
+        } else {
+            Quaternion_rotate(&in->q1[i], in->v[i], in->to[i]);
+        }
+        for(int k = 0; k < 3; k++)
+            in->toArray[k][i] = in->to[i][k];
+
+        QuaternionArray q1 = toArray(in->q1Array);
+        QuaternionArray q2 = toArray(in->q2Array);
+        Quaternion_store(&in->q1[i], &q1, i);
+        Quaternion_store(&in->q2[i], &q2, i);
+        in->prefix[i] = (i == 0) ? toLong(&in->q1[i]) : longMultiply(in->prefix[i - 1], toLong(&in->q1[i]));
+    }
+}
+
+/**
+ * Random joint limits, the same for all domains. Every 8th joint has none.
+ */
+static void fillLimits(void)
+{
+    for(size_t i = 0; i < SAMPLE_COUNT; i++) {
+        double axis[3];
+        randomAxis(axis);
+        bool unlimited = i % 8 == 0;
+        jointCone[i] = unlimited ? M_PI : randomUniform(0, M_PI);
+        jointTwistMin[i] = unlimited ? -M_PI : randomUniform(-M_PI, 0);
+        jointTwistMax[i] = unlimited ? M_PI : randomUniform(0, M_PI);
+        QuaternionJointLimits_set(&joints, i, axis, jointCone[i], jointTwistMin[i], jointTwistMax[i]);
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+static double seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool runKernel(Kernel* kernel, Domain domain)
+{
+    Inputs* in = &inputs[domain];
+
+    double start = seconds();
+    for(int r = 0; r < TIMING_REPEATS; r++)
+        kernel->run(in, &outputs);
+    double elapsed = seconds() - start;
+    double throughput = (double)SAMPLE_COUNT * TIMING_REPEATS / elapsed * 1e-6;
+
+    ErrorStats stats = {0};
+    for(size_t i = 0; i < SAMPLE_COUNT; i++)
+        kernel->check(in, &outputs, i, &stats);
+
+    bool passed = stats.maxAngle <= kernel->maxAngle && stats.maxUlp <= kernel->maxUlp;
+    printf("%-34s %-14s %10.3e %10.3e %10.3g %10.3g %9.1f %s\n",
+        kernel->name, DOMAIN_NAMES[domain],
+        stats.maxAngle, stats.sumAngle / stats.count,
+        stats.maxUlp, stats.sumUlp / stats.count,
+        throughput, passed ? "" : "FAILED");
+    if(!passed) {
+        fprintf(stderr, "TEST FAILED: %s (%s) exceeds bounds (angle %g > %g or ulp %g > %g)\n",
+            kernel->name, DOMAIN_NAMES[domain],
+            stats.maxAngle, kernel->maxAngle, stats.maxUlp, kernel->maxUlp);
+    }
+    return passed;
+}
+
+int main(void)
+{
+    for(int d = 0; d < DOMAIN_COUNT; d++)
+        fillInputs((Domain)d, &inputs[d]);
+
+    printf("%-34s %-14s %10s %10s %10s %10s %9s\n",
+        "kernel", "domain", "max rad", "mean rad", "max ulp", "mean ulp", "Mop/s");
+
+    if(!QuaternionFusion_init(&fusion, SAMPLE_COUNT, FUSION_GAIN, FUSION_INTEGRAL_GAIN)) {
+        fprintf(stderr, "TEST FAILED: QuaternionFusion_init\n");
+        return EXIT_FAILURE;
+    }
+    if(!QuaternionJointLimits_init(&joints, SAMPLE_COUNT)) {
+        fprintf(stderr, "TEST FAILED: QuaternionJointLimits_init\n");
+        return EXIT_FAILURE;
+    }
+    fillLimits();
+
+    bool passed = true;
+    for(size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        for(int d = 0; d < DOMAIN_COUNT; d++) {
+            if(kernels[k].domains & (1u << d))
+                passed &= runKernel(&kernels[k], (Domain)d);
+        }
+    }
+    QuaternionFusion_free(&fusion);
+    QuaternionJointLimits_free(&joints);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
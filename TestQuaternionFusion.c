@@ -0,0 +1,214 @@
+// TEST: gcc -std=c17 -Wall -Wextra TestQuaternionFusion.c QuaternionFusion.c Quaternion.c -lm -o TestQuaternionFusion.exe; ./TestQuaternionFusion.exe
+#include <stdlib.h>
+#include "QuaternionFusion.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+#define TO_RAD(x) (x / 180.0 * M_PI)
+
+void ASSERT_SAME_DOUBLE(char* description, double x, double y)
+{
+    if(fabs(x - y) > QUATERNION_EPS) {
+        fprintf(stderr, "TEST FAILED: %s (%f != %f)\n", description, x, y);
+    }
+}
+void ASSERT_TRUE(char* description, bool check)
+{
+    if(!check) {
+        fprintf(stderr, "TEST FAILED: %s\n", description);
+    }
+}
+void ASSERT_FALSE(char* description, bool check) { ASSERT_TRUE(description, !check); }
+
+#define SENSORS 3
+
+/**
+ * Simulated readings of static sensors with the given orientations.
+ */
+typedef struct Readings {
+    double gyro[3][SENSORS];
+    double accel[3][SENSORS];
+    double mag[3][SENSORS];
+} Readings;
+
+static void simulate(Quaternion orientations[SENSORS], Readings* r)
+{
+    // Magnetic field pointing north (X-axis) and down
+    double gravity[3] = {0, 0, 1};
+    double field[3] = {0.5, 0, -0.866};
+    for(int i = 0; i < SENSORS; i++) {
+        Quaternion inverse;
+        double a[3], m[3];
+        Quaternion_conjugate(&orientations[i], &inverse);
+        Quaternion_rotate(&inverse, gravity, a);
+        Quaternion_rotate(&inverse, field, m);
+        for(int k = 0; k < 3; k++) {
+            r->gyro[k][i] = 0;
+            r->accel[k][i] = 9.81 * a[k];
+            r->mag[k][i] = 50.0 * m[k];
+        }
+    }
+}
+
+static void setupOrientations(Quaternion orientations[SENSORS])
+{
+    double e1[3] = {TO_RAD(30.0), TO_RAD(-20.0), TO_RAD(60.0)};
+    double e2[3] = {TO_RAD(-45.0), TO_RAD(10.0), TO_RAD(-120.0)};
+    Quaternion_fromXRotation(TO_RAD(30.0), &orientations[0]);
+    Quaternion_fromEulerZYX(e1, &orientations[1]);
+    Quaternion_fromEulerZYX(e2, &orientations[2]);
+}
+
+void testQuaternionFusion_init(void)
+{
+    QuaternionFusion f;
+    Quaternion q, identity;
+    Quaternion_setIdentity(&identity);
+    ASSERT_TRUE("QuaternionFusion_init succeeds", QuaternionFusion_init(&f, SENSORS, 0.5, 0.1));
+    Quaternion_load(&f.orientation, 2, &q);
+    ASSERT_TRUE("QuaternionFusion_init sets identity", Quaternion_equal(&q, &identity));
+    ASSERT_SAME_DOUBLE("QuaternionFusion_init sets gain", f.gain[2], 0.5);
+    ASSERT_SAME_DOUBLE("QuaternionFusion_init sets integral gain", f.integralGain[2], 0.1);
+    QuaternionFusion_free(&f);
+}
+
+void testQuaternionFusion_updateMadgwick(void)
+{
+    Quaternion orientations[SENSORS], q;
+    Readings r;
+    setupOrientations(orientations);
+    simulate(orientations, &r);
+    double* gyro[3] = {r.gyro[0], r.gyro[1], r.gyro[2]};
+    double* accel[3] = {r.accel[0], r.accel[1], r.accel[2]};
+    double* mag[3] = {r.mag[0], r.mag[1], r.mag[2]};
+
+    QuaternionFusion f;
+    QuaternionFusion_init(&f, SENSORS, 0.5, 0);
+    for(int step = 0; step < 2000; step++)
+        QuaternionFusion_updateMadgwick(&f, gyro, accel, mag, 0.01);
+
+    // Each step has a length of gain * dt, so lower the gain for precision
+    for(int i = 0; i < SENSORS; i++)
+        f.gain[i] = 0.001;
+    for(int step = 0; step < 2000; step++)
+        QuaternionFusion_updateMadgwick(&f, gyro, accel, mag, 0.01);
+
+    Quaternion_load(&f.orientation, 0, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMadgwick converges (sensor 0)", Quaternion_equal(&q, &orientations[0]));
+    Quaternion_load(&f.orientation, 1, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMadgwick converges (sensor 1)", Quaternion_equal(&q, &orientations[1]));
+    Quaternion_load(&f.orientation, 2, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMadgwick converges (sensor 2)", Quaternion_equal(&q, &orientations[2]));
+    QuaternionFusion_free(&f);
+}
+
+void testQuaternionFusion_updateMahony(void)
+{
+    Quaternion orientations[SENSORS], q;
+    Readings r;
+    setupOrientations(orientations);
+    simulate(orientations, &r);
+    double* gyro[3] = {r.gyro[0], r.gyro[1], r.gyro[2]};
+    double* accel[3] = {r.accel[0], r.accel[1], r.accel[2]};
+    double* mag[3] = {r.mag[0], r.mag[1], r.mag[2]};
+
+    QuaternionFusion f;
+    QuaternionFusion_init(&f, SENSORS, 2.0, 0);
+    for(int step = 0; step < 5000; step++)
+        QuaternionFusion_updateMahony(&f, gyro, accel, mag, 0.01);
+
+    Quaternion_load(&f.orientation, 0, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMahony converges (sensor 0)", Quaternion_equal(&q, &orientations[0]));
+    Quaternion_load(&f.orientation, 1, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMahony converges (sensor 1)", Quaternion_equal(&q, &orientations[1]));
+    Quaternion_load(&f.orientation, 2, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMahony converges (sensor 2)", Quaternion_equal(&q, &orientations[2]));
+    QuaternionFusion_free(&f);
+}
+
+void testQuaternionFusion_gyroscopeBias(void)
+{
+    Quaternion orientations[SENSORS], q;
+    Readings r;
+    setupOrientations(orientations);
+    simulate(orientations, &r);
+    for(int i = 0; i < SENSORS; i++)
+        r.gyro[2][i] = 0.02;
+    double* gyro[3] = {r.gyro[0], r.gyro[1], r.gyro[2]};
+    double* accel[3] = {r.accel[0], r.accel[1], r.accel[2]};
+    double* mag[3] = {r.mag[0], r.mag[1], r.mag[2]};
+
+    // The integral feedback compensates a constant gyroscope bias
+    QuaternionFusion f;
+    QuaternionFusion_init(&f, SENSORS, 2.0, 1.0);
+    for(int step = 0; step < 20000; step++)
+        QuaternionFusion_updateMahony(&f, gyro, accel, mag, 0.01);
+
+    Quaternion_load(&f.orientation, 1, &q);
+    ASSERT_TRUE("QuaternionFusion_updateMahony compensates bias", Quaternion_equal(&q, &orientations[1]));
+    ASSERT_SAME_DOUBLE("QuaternionFusion_updateMahony integrates bias (X-axis)", f.integralError[0][1], 0);
+    ASSERT_SAME_DOUBLE("QuaternionFusion_updateMahony integrates bias (Z-axis)", f.integralError[2][1], -0.02);
+    QuaternionFusion_free(&f);
+}
+
+void testQuaternionFusion_withoutMagnetometer(void)
+{
+    Quaternion orientations[SENSORS], q;
+    Readings r;
+    setupOrientations(orientations);
+    simulate(orientations, &r);
+    double* gyro[3] = {r.gyro[0], r.gyro[1], r.gyro[2]};
+    double* accel[3] = {r.accel[0], r.accel[1], r.accel[2]};
+
+    QuaternionFusion f;
+    QuaternionFusion_init(&f, SENSORS, 2.0, 0);
+    for(int step = 0; step < 5000; step++)
+        QuaternionFusion_updateMahony(&f, gyro, accel, NULL, 0.01);
+
+    // Without magnetometer only the direction of gravity is observable
+    double up[3] = {0, 0, 1}, estimated[3], real[3];
+    Quaternion_load(&f.orientation, 1, &q);
+    Quaternion_conjugate(&q, &q);
+    Quaternion_rotate(&q, up, estimated);
+    Quaternion_conjugate(&orientations[1], &q);
+    Quaternion_rotate(&q, up, real);
+    ASSERT_SAME_DOUBLE("QuaternionFusion without magnetometer (X-axis)", estimated[0], real[0]);
+    ASSERT_SAME_DOUBLE("QuaternionFusion without magnetometer (Y-axis)", estimated[1], real[1]);
+    ASSERT_SAME_DOUBLE("QuaternionFusion without magnetometer (Z-axis)", estimated[2], real[2]);
+    QuaternionFusion_free(&f);
+}
+
+void testQuaternionFusion_gyroscope(void)
+{
+    // Zero accelerometer readings disable the correction: pure integration
+    double rate[SENSORS] = {0, 0, 0}, turn[SENSORS] = {1.0, 0.5, -2.0};
+    double* gyro[3] = {rate, rate, turn};
+    double* accel[3] = {rate, rate, rate};
+
+    QuaternionFusion f;
+    QuaternionFusion_init(&f, SENSORS, 0.5, 0);
+    for(int step = 0; step < 1000; step++) {
+        QuaternionFusion_updateMadgwick(&f, gyro, accel, NULL, 0.001);
+        QuaternionFusion_updateMahony(&f, gyro, accel, NULL, 0.001);
+    }
+
+    Quaternion q, real;
+    for(int i = 0; i < SENSORS; i++) {
+        Quaternion_load(&f.orientation, i, &q);
+        Quaternion_fromZRotation(2 * turn[i], &real);
+        ASSERT_TRUE("QuaternionFusion integrates gyroscope", Quaternion_equal(&q, &real));
+    }
+    QuaternionFusion_free(&f);
+}
+
+int main(void)
+{
+    testQuaternionFusion_init();
+    testQuaternionFusion_updateMadgwick();
+    testQuaternionFusion_updateMahony();
+    testQuaternionFusion_gyroscopeBias();
+    testQuaternionFusion_withoutMagnetometer();
+    testQuaternionFusion_gyroscope();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+// TEST: gcc -std=c17 -Wall -Wextra TestQuaternionHierarchy.c QuaternionHierarchy.c Quaternion.c -lm -o TestQuaternionHierarchy.exe; ./TestQuaternionHierarchy.exe
+#include <stdlib.h>
+#include "QuaternionHierarchy.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+#define TO_RAD(x) (x / 180.0 * M_PI)
+
+void ASSERT_SAME_DOUBLE(char* description, double x, double y)
+{
+    if(fabs(x - y) > QUATERNION_EPS) {
+        fprintf(stderr, "TEST FAILED: %s (%f != %f)\n", description, x, y);
+    }
+}
+void ASSERT_TRUE(char* description, bool check)
+{
+    if(!check) {
+        fprintf(stderr, "TEST FAILED: %s\n", description);
+    }
+}
+void ASSERT_FALSE(char* description, bool check) { ASSERT_TRUE(description, !check); }
+
+// Two chains below one root:  0 -> 1 -> 2  and  0 -> 3 -> 4
+static const int32_t PARENTS[5] = {-1, 0, 1, 0, 3};
+
+void testQuaternionHierarchy_init(void)
+{
+    QuaternionHierarchy h;
+    Quaternion q, identity;
+    Quaternion_setIdentity(&identity);
+    ASSERT_TRUE("QuaternionHierarchy_init with depth-first order", QuaternionHierarchy_init(&h, PARENTS, 5, false));
+    ASSERT_TRUE("QuaternionHierarchy_init stores subtree size", h.subtreeSize[0] == 5 && h.subtreeSize[3] == 2);
+    QuaternionHierarchy_getWorldRotation(&h, 4, &q);
+    ASSERT_TRUE("QuaternionHierarchy_init sets identity", Quaternion_equal(&q, &identity));
+    QuaternionHierarchy_free(&h);
+
+    const int32_t childFirst[3] = {1, -1, 1};
+    ASSERT_FALSE("QuaternionHierarchy_init rejects children before parents",
+        QuaternionHierarchy_init(&h, childFirst, 3, false));
+    const int32_t interleaved[4] = {-1, 0, -1, 0};
+    ASSERT_FALSE("QuaternionHierarchy_init rejects non-contiguous subtrees",
+        QuaternionHierarchy_init(&h, interleaved, 4, false));
+}
+
+void testQuaternionHierarchy_update(void)
+{
+    QuaternionHierarchy h;
+    QuaternionHierarchy_init(&h, PARENTS, 5, false);
+
+    Quaternion rotX, rotZ, q, real;
+    Quaternion_fromXRotation(TO_RAD(90.0), &rotX);
+    Quaternion_fromZRotation(TO_RAD(90.0), &rotZ);
+    QuaternionHierarchy_setLocalRotation(&h, 0, &rotZ);
+    QuaternionHierarchy_setLocalRotation(&h, 2, &rotX);
+    ASSERT_TRUE("QuaternionHierarchy_update after root change updates all", QuaternionHierarchy_update(&h) == 5);
+
+    QuaternionHierarchy_getWorldRotation(&h, 2, &q);
+    Quaternion_multiply(&rotZ, &rotX, &real);
+    ASSERT_TRUE("QuaternionHierarchy_update chains rotations", Quaternion_equal(&q, &real));
+    QuaternionHierarchy_getWorldRotation(&h, 4, &q);
+    ASSERT_TRUE("QuaternionHierarchy_update propagates the root", Quaternion_equal(&q, &rotZ));
+
+    ASSERT_TRUE("QuaternionHierarchy_update without changes", QuaternionHierarchy_update(&h) == 0);
+
+    uint32_t nodes[2] = {4, 3};
+    Quaternion rotations[2] = {rotX, rotX};
+    QuaternionHierarchy_setLocalRotations(&h, nodes, rotations, 2);
+    ASSERT_TRUE("QuaternionHierarchy_update only updates dirty subtrees", QuaternionHierarchy_update(&h) == 2);
+    QuaternionHierarchy_getWorldRotation(&h, 4, &q);
+    Quaternion_multiply(&rotZ, &rotX, &real);
+    Quaternion_multiply(&real, &rotX, &real);
+    ASSERT_TRUE("QuaternionHierarchy_setLocalRotations", Quaternion_equal(&q, &real));
+    QuaternionHierarchy_free(&h);
+}
+
+void testQuaternionHierarchy_translation(void)
+{
+    QuaternionHierarchy h;
+    QuaternionHierarchy_init(&h, PARENTS, 5, true);
+
+    Quaternion rotZ;
+    Quaternion_fromZRotation(TO_RAD(90.0), &rotZ);
+    double base[3] = {1, 2, 3};
+    double arm[3] = {2, 0, 0};
+    QuaternionHierarchy_setLocalTranslation(&h, 0, base);
+    QuaternionHierarchy_setLocalRotation(&h, 0, &rotZ);
+    QuaternionHierarchy_setLocalTranslation(&h, 3, arm);
+    QuaternionHierarchy_setLocalTranslation(&h, 4, arm);
+    QuaternionHierarchy_update(&h);
+
+    double t[3];
+    QuaternionHierarchy_getWorldTranslation(&h, 4, t);
+    ASSERT_SAME_DOUBLE("QuaternionHierarchy translation (X-axis)", t[0], 1);
+    ASSERT_SAME_DOUBLE("QuaternionHierarchy translation (Y-axis)", t[1], 6);
+    ASSERT_SAME_DOUBLE("QuaternionHierarchy translation (Z-axis)", t[2], 3);
+    QuaternionHierarchy_free(&h);
+}
+
+int main(void)
+{
+    testQuaternionHierarchy_init();
+    testQuaternionHierarchy_update();
+    testQuaternionHierarchy_translation();
+    return EXIT_SUCCESS;
+}
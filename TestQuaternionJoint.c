@@ -0,0 +1,157 @@
+// TEST: gcc -std=c17 -Wall -Wextra TestQuaternionJoint.c QuaternionJoint.c Quaternion.c -lm -o TestQuaternionJoint.exe; ./TestQuaternionJoint.exe
+#include <stdlib.h>
+#include "QuaternionJoint.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+#define TO_RAD(x) (x / 180.0 * M_PI)
+
+void ASSERT_SAME_DOUBLE(char* description, double x, double y)
+{
+    if(fabs(x - y) > QUATERNION_EPS) {
+        fprintf(stderr, "TEST FAILED: %s (%f != %f)\n", description, x, y);
+    }
+}
+void ASSERT_TRUE(char* description, bool check)
+{
+    if(!check) {
+        fprintf(stderr, "TEST FAILED: %s\n", description);
+    }
+}
+void ASSERT_FALSE(char* description, bool check) { ASSERT_TRUE(description, !check); }
+
+#define JOINTS 4
+
+static double w[JOINTS], x[JOINTS], y[JOINTS], z[JOINTS];
+static double rw[JOINTS], rx[JOINTS], ry[JOINTS], rz[JOINTS];
+static QuaternionArray rotations = {w, {x, y, z}};
+static QuaternionArray result = {rw, {rx, ry, rz}};
+
+/**
+ * Rotation of swing around the Z-axis after twist around the X-axis.
+ */
+static void swingTwist(double swing, double twist, Quaternion* output)
+{
+    Quaternion s, t;
+    Quaternion_fromZRotation(TO_RAD(swing), &s);
+    Quaternion_fromXRotation(TO_RAD(twist), &t);
+    Quaternion_multiply(&s, &t, output);
+}
+
+void testQuaternionJointLimits_init(void)
+{
+    QuaternionJointLimits limits;
+    ASSERT_TRUE("QuaternionJointLimits_init succeeds", QuaternionJointLimits_init(&limits, JOINTS));
+    ASSERT_TRUE("QuaternionJointLimits_init sets the count", limits.count == JOINTS);
+
+    // Without limits, every rotation is kept
+    Quaternion q, r;
+    double e[3] = {TO_RAD(170.0), TO_RAD(-80.0), TO_RAD(120.0)};
+    Quaternion_fromEulerZYX(e, &q);
+    for(int i = 0; i < JOINTS; i++)
+        Quaternion_store(&q, &rotations, i);
+    QuaternionJointLimits_clamp(&limits, &rotations, &result);
+    for(int i = 0; i < JOINTS; i++) {
+        Quaternion_load(&result, i, &r);
+        ASSERT_TRUE("QuaternionJointLimits_clamp without limits", Quaternion_equal(&q, &r));
+    }
+    QuaternionJointLimits_free(&limits);
+}
+
+void testQuaternionJointLimits_twist(void)
+{
+    QuaternionJointLimits limits;
+    QuaternionJointLimits_init(&limits, JOINTS);
+    double axis[3] = {2, 0, 0};
+    for(int i = 0; i < JOINTS; i++)
+        QuaternionJointLimits_set(&limits, i, axis, M_PI, TO_RAD(-30.0), TO_RAD(45.0));
+
+    double twists[JOINTS] = {90.0, -60.0, 20.0, -179.0};
+    double clamped[JOINTS] = {45.0, -30.0, 20.0, -30.0};
+    for(int i = 0; i < JOINTS; i++) {
+        Quaternion q;
+        swingTwist(50.0, twists[i], &q);
+        Quaternion_store(&q, &rotations, i);
+    }
+    QuaternionJointLimits_clamp(&limits, &rotations, &result);
+    for(int i = 0; i < JOINTS; i++) {
+        Quaternion q, r;
+        swingTwist(50.0, clamped[i], &q);
+        Quaternion_load(&result, i, &r);
+        ASSERT_TRUE("QuaternionJointLimits_clamp limits the twist and keeps the swing", Quaternion_equal(&q, &r));
+    }
+    QuaternionJointLimits_free(&limits);
+}
+
+void testQuaternionJointLimits_cone(void)
+{
+    QuaternionJointLimits limits;
+    QuaternionJointLimits_init(&limits, JOINTS);
+    double axis[3] = {1, 0, 0};
+    for(int i = 0; i < JOINTS; i++)
+        QuaternionJointLimits_set(&limits, i, axis, TO_RAD(30.0), -M_PI, M_PI);
+
+    // A swing of 90 degrees is no gimbal lock for the decomposition
+    double swings[JOINTS] = {60.0, -90.0, 10.0, 150.0};
+    double clamped[JOINTS] = {30.0, -30.0, 10.0, 30.0};
+    for(int i = 0; i < JOINTS; i++) {
+        Quaternion q;
+        swingTwist(swings[i], 70.0, &q);
+        Quaternion_store(&q, &rotations, i);
+    }
+    QuaternionJointLimits_clamp(&limits, &rotations, &result);
+    for(int i = 0; i < JOINTS; i++) {
+        Quaternion q, r;
+        swingTwist(clamped[i], 70.0, &q);
+        Quaternion_load(&result, i, &r);
+        ASSERT_TRUE("QuaternionJointLimits_clamp limits the swing and keeps the twist", Quaternion_equal(&q, &r));
+    }
+    QuaternionJointLimits_free(&limits);
+}
+
+void testQuaternionJointLimits_clamp(void)
+{
+    QuaternionJointLimits limits;
+    QuaternionJointLimits_init(&limits, JOINTS);
+    double axis[3] = {1, 0, 0}, tilted[3] = {0, 1, 1};
+    QuaternionJointLimits_set(&limits, 0, axis, TO_RAD(30.0), TO_RAD(-10.0), TO_RAD(10.0));
+    QuaternionJointLimits_set(&limits, 1, axis, TO_RAD(30.0), TO_RAD(-10.0), TO_RAD(10.0));
+    QuaternionJointLimits_set(&limits, 2, tilted, 0, 0, 0);
+
+    // Both limits at once, keeping the sign of the input
+    Quaternion q, r, real;
+    swingTwist(-80.0, 120.0, &q);
+    Quaternion_store(&q, &rotations, 0);
+    Quaternion_set(-q.w, -q.v[0], -q.v[1], -q.v[2], &q);
+    Quaternion_store(&q, &rotations, 1);
+    swingTwist(-30.0, 10.0, &real);
+
+    // Locked joint
+    Quaternion_fromYRotation(TO_RAD(40.0), &q);
+    Quaternion_store(&q, &rotations, 2);
+    Quaternion_setIdentity(&q);
+    Quaternion_store(&q, &rotations, 3);
+
+    // In place
+    QuaternionJointLimits_clamp(&limits, &rotations, &rotations);
+    Quaternion_load(&rotations, 0, &r);
+    ASSERT_TRUE("QuaternionJointLimits_clamp limits swing and twist", Quaternion_equal(&r, &real));
+    Quaternion_load(&rotations, 1, &r);
+    Quaternion_set(-real.w, -real.v[0], -real.v[1], -real.v[2], &real);
+    ASSERT_TRUE("QuaternionJointLimits_clamp keeps the sign", Quaternion_equal(&r, &real));
+    Quaternion_load(&rotations, 2, &r);
+    ASSERT_TRUE("QuaternionJointLimits_clamp of a locked joint", Quaternion_equal(&r, &q));
+    Quaternion_load(&rotations, 3, &r);
+    ASSERT_TRUE("QuaternionJointLimits_clamp of identity", Quaternion_equal(&r, &q));
+    QuaternionJointLimits_free(&limits);
+}
+
+int main(void)
+{
+    testQuaternionJointLimits_init();
+    testQuaternionJointLimits_twist();
+    testQuaternionJointLimits_cone();
+    testQuaternionJointLimits_clamp();
+    return EXIT_SUCCESS;
+}
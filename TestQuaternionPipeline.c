@@ -0,0 +1,277 @@
+// TEST: gcc -std=c17 -Wall -Wextra -pthread TestQuaternionPipeline.c QuaternionPipeline.c Quaternion.c -lm -o TestQuaternionPipeline.exe; ./TestQuaternionPipeline.exe
+#include <stdlib.h>
+#include "QuaternionPipeline.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+#define TO_RAD(x) (x / 180.0 * M_PI)
+
+void ASSERT_SAME_DOUBLE(char* description, double x, double y)
+{
+    if(fabs(x - y) > QUATERNION_EPS) {
+        fprintf(stderr, "TEST FAILED: %s (%f != %f)\n", description, x, y);
+    }
+}
+void ASSERT_TRUE(char* description, bool check)
+{
+    if(!check) {
+        fprintf(stderr, "TEST FAILED: %s\n", description);
+    }
+}
+void ASSERT_FALSE(char* description, bool check) { ASSERT_TRUE(description, !check); }
+
+#define BATCH_SIZE 256
+#define BATCH_COUNT 8
+#define ROUNDS 50
+
+void testQuaternionQueue_pushPop(void)
+{
+    QuaternionQueue queue;
+    QuaternionBatch batches[4];
+    ASSERT_TRUE("QuaternionQueue_init succeeds", QuaternionQueue_init(&queue, 3, false, false));
+    ASSERT_TRUE("QuaternionQueue_pop from empty queue", QuaternionQueue_pop(&queue) == NULL);
+
+    // The capacity is rounded up to a power of two
+    for(int i = 0; i < 4; i++)
+        ASSERT_TRUE("QuaternionQueue_push", QuaternionQueue_push(&queue, &batches[i]));
+    ASSERT_FALSE("QuaternionQueue_push into full queue", QuaternionQueue_push(&queue, &batches[0]));
+
+    ASSERT_TRUE("QuaternionQueue_pop is first in, first out", QuaternionQueue_pop(&queue) == &batches[0]);
+    ASSERT_TRUE("QuaternionQueue_push after pop", QuaternionQueue_push(&queue, &batches[0]));
+    ASSERT_TRUE("QuaternionQueue_pop wraps around (1)", QuaternionQueue_pop(&queue) == &batches[1]);
+    ASSERT_TRUE("QuaternionQueue_pop wraps around (2)", QuaternionQueue_pop(&queue) == &batches[2]);
+    ASSERT_TRUE("QuaternionQueue_pop wraps around (3)", QuaternionQueue_pop(&queue) == &batches[3]);
+    ASSERT_TRUE("QuaternionQueue_pop wraps around (0)", QuaternionQueue_pop(&queue) == &batches[0]);
+    ASSERT_TRUE("QuaternionQueue_pop after all", QuaternionQueue_pop(&queue) == NULL);
+    QuaternionQueue_free(&queue);
+}
+
+typedef struct QueueTest {
+    QuaternionQueue* queue;
+    QuaternionBatch* batches;
+    int count;
+    atomic_int* seen;
+} QueueTest;
+
+static int produce(void* arg)
+{
+    QueueTest* t = arg;
+    for(int i = 0; i < t->count; i++) {
+        while(!QuaternionQueue_push(t->queue, &t->batches[i]))
+            thrd_yield();
+    }
+    return 0;
+}
+
+static int consume(void* arg)
+{
+    QueueTest* t = arg;
+    for(int i = 0; i < t->count; i++) {
+        QuaternionBatch* batch;
+        while((batch = QuaternionQueue_pop(t->queue)) == NULL)
+            thrd_yield();
+        atomic_fetch_add(&t->seen[batch->count], 1);
+    }
+    return 0;
+}
+
+void testQuaternionQueue_multiThreaded(void)
+{
+    // Two producers and two consumers: every batch arrives exactly once
+    enum { PER_THREAD = 5000 };
+    static QuaternionBatch batches[2][PER_THREAD];
+    static atomic_int seen[2 * PER_THREAD];
+    for(int i = 0; i < 2 * PER_THREAD; i++) {
+        batches[i / PER_THREAD][i % PER_THREAD].count = (size_t)i;
+        atomic_init(&seen[i], 0);
+    }
+
+    QuaternionQueue queue;
+    QuaternionQueue_init(&queue, 16, true, true);
+    QueueTest producers[2] = {{&queue, batches[0], PER_THREAD, seen}, {&queue, batches[1], PER_THREAD, seen}};
+    QueueTest consumers[2] = {{&queue, NULL, PER_THREAD, seen}, {&queue, NULL, PER_THREAD, seen}};
+    thrd_t threads[4];
+    thrd_create(&threads[0], produce, &producers[0]);
+    thrd_create(&threads[1], produce, &producers[1]);
+    thrd_create(&threads[2], consume, &consumers[0]);
+    thrd_create(&threads[3], consume, &consumers[1]);
+    for(int i = 0; i < 4; i++)
+        thrd_join(threads[i], NULL);
+
+    bool once = true;
+    for(int i = 0; i < 2 * PER_THREAD; i++)
+        once &= atomic_load(&seen[i]) == 1;
+    ASSERT_TRUE("QuaternionQueue with multiple producers and consumers", once);
+    ASSERT_TRUE("QuaternionQueue is empty afterwards", QuaternionQueue_pop(&queue) == NULL);
+    QuaternionQueue_free(&queue);
+}
+
+// Stages of the test pipeline: decode, integrate, rotate, encode
+
+static void decode(QuaternionBatch* batch, void* context)
+{
+    (void)context;
+    // Angular rate around the Z-axis and a vector along the X-axis
+    for(size_t i = 0; i < batch->count; i++) {
+        batch->q.w[i] = 1;
+        batch->q.v[0][i] = batch->q.v[1][i] = batch->q.v[2][i] = 0;
+        batch->v[0][i] = 0;
+        batch->v[1][i] = 0;
+        batch->v[2][i] = TO_RAD(90.0);
+    }
+}
+
+static void integrate(QuaternionBatch* batch, void* context)
+{
+    (void)context;
+    Quaternion_boxplusArray(&batch->q, batch->v, batch->count, &batch->q);
+    for(size_t i = 0; i < batch->count; i++) {
+        batch->v[0][i] = 1;
+        batch->v[1][i] = 0;
+        batch->v[2][i] = 0;
+    }
+}
+
+static void encode(QuaternionBatch* batch, void* context)
+{
+    atomic_int* errors = context;
+    for(size_t i = 0; i < batch->count; i++) {
+        if(fabs(batch->v[0][i]) > QUATERNION_EPS || fabs(batch->v[1][i] - 1) > QUATERNION_EPS)
+            atomic_fetch_add(errors, 1);
+    }
+}
+
+static void runPipeline(QuaternionStage* stages, size_t stageCount)
+{
+    static QuaternionBatch batches[BATCH_COUNT];
+    for(int b = 0; b < BATCH_COUNT; b++) {
+        QuaternionBatch_init(&batches[b], BATCH_SIZE);
+        batches[b].count = BATCH_SIZE;
+    }
+
+    QuaternionPipeline p;
+    ASSERT_TRUE("QuaternionPipeline_init succeeds", QuaternionPipeline_init(&p, stages, stageCount, 4));
+
+    // Keep all batches in flight, recycling each one when it is received
+    for(int b = 0; b < BATCH_COUNT; b++)
+        QuaternionPipeline_submit(&p, &batches[b]);
+    for(int r = 0; r < ROUNDS * BATCH_COUNT; r++) {
+        QuaternionBatch* batch = QuaternionPipeline_receive(&p);
+        if(r < (ROUNDS - 1) * BATCH_COUNT)
+            QuaternionPipeline_submit(&p, batch);
+    }
+    ASSERT_TRUE("QuaternionPipeline is empty afterwards", QuaternionPipeline_tryReceive(&p) == NULL);
+
+    QuaternionStageStats stats;
+    for(size_t s = 0; s < stageCount; s++) {
+        QuaternionPipeline_getStats(&p, s, &stats);
+        ASSERT_TRUE("QuaternionPipeline counts batches", stats.batches == ROUNDS * BATCH_COUNT);
+        ASSERT_TRUE("QuaternionPipeline counts elements", stats.elements == ROUNDS * BATCH_COUNT * BATCH_SIZE);
+        ASSERT_TRUE("QuaternionPipeline measures latency", stats.maxLatency >= stats.meanLatency);
+    }
+    QuaternionPipeline_free(&p);
+    for(int b = 0; b < BATCH_COUNT; b++)
+        QuaternionBatch_free(&batches[b]);
+}
+
+void testQuaternionPipeline_stages(void)
+{
+    atomic_int errors;
+    atomic_init(&errors, 0);
+    QuaternionStage stages[4] = {
+        {"decode", decode, NULL, 1},
+        {"integrate", integrate, NULL, 1},
+        {"rotate", QuaternionPipeline_rotate, NULL, 1},
+        {"encode", encode, &errors, 1},
+    };
+    runPipeline(stages, 4);
+    ASSERT_TRUE("QuaternionPipeline runs all stages in order", atomic_load(&errors) == 0);
+}
+
+void testQuaternionPipeline_multipleWorkers(void)
+{
+    atomic_int errors;
+    atomic_init(&errors, 0);
+    QuaternionStage stages[4] = {
+        {"decode", decode, NULL, 1},
+        {"integrate", integrate, NULL, 3},
+        {"rotate", QuaternionPipeline_rotate, NULL, 2},
+        {"encode", encode, &errors, 1},
+    };
+    runPipeline(stages, 4);
+    ASSERT_TRUE("QuaternionPipeline with multiple workers per stage", atomic_load(&errors) == 0);
+}
+
+typedef struct Gate {
+    atomic_int entered;             // Batches that reached the stage function
+    atomic_bool open;               // The stage function returns once open
+} Gate;
+
+static void gate(QuaternionBatch* batch, void* context)
+{
+    (void)batch;
+    Gate* g = context;
+    atomic_fetch_add(&g->entered, 1);
+    while(!atomic_load(&g->open))
+        thrd_yield();
+}
+
+static void waitUntilEntered(Gate* g, int batches)
+{
+    while(atomic_load(&g->entered) < batches)
+        thrd_yield();
+}
+
+void testQuaternionPipeline_backpressure(void)
+{
+    Gate gates[2];
+    for(int s = 0; s < 2; s++)
+        atomic_init(&gates[s].entered, 0);
+    atomic_init(&gates[0].open, true);
+    atomic_init(&gates[1].open, false);
+    QuaternionStage stages[2] = {
+        {"pass", gate, &gates[0], 1},
+        {"blocked", gate, &gates[1], 1},
+    };
+    QuaternionBatch batches[7];
+    for(int b = 0; b < 7; b++) {
+        QuaternionBatch_init(&batches[b], 1);
+        batches[b].count = 0;
+    }
+    QuaternionPipeline p;
+    QuaternionPipeline_init(&p, stages, 2, 2);
+
+    // The second stage holds the first batch, the queue in between two more,
+    // and the first stage the fourth one, which it cannot pass on
+    QuaternionPipeline_submit(&p, &batches[0]);
+    waitUntilEntered(&gates[1], 1);
+    for(int b = 1; b < 4; b++)
+        QuaternionPipeline_submit(&p, &batches[b]);
+    waitUntilEntered(&gates[0], 4);
+
+    // Only the first queue is left
+    ASSERT_TRUE("QuaternionPipeline_trySubmit into free queue", QuaternionPipeline_trySubmit(&p, &batches[4]));
+    ASSERT_TRUE("QuaternionPipeline_trySubmit into free queue", QuaternionPipeline_trySubmit(&p, &batches[5]));
+    ASSERT_FALSE("QuaternionPipeline_trySubmit rejects batches when full", QuaternionPipeline_trySubmit(&p, &batches[6]));
+
+    atomic_store(&gates[1].open, true);
+    for(int b = 0; b < 6; b++)
+        ASSERT_TRUE("QuaternionPipeline keeps the order", QuaternionPipeline_receive(&p) == &batches[b]);
+    QuaternionStageStats stats;
+    QuaternionPipeline_getStats(&p, 0, &stats);
+    ASSERT_TRUE("QuaternionPipeline measures stalls", stats.stallTime > 0);
+    QuaternionPipeline_free(&p);
+    for(int b = 0; b < 7; b++)
+        QuaternionBatch_free(&batches[b]);
+}
+
+int main(void)
+{
+    testQuaternionQueue_pushPop();
+    testQuaternionQueue_multiThreaded();
+    testQuaternionPipeline_stages();
+    testQuaternionPipeline_multipleWorkers();
+    testQuaternionPipeline_backpressure();
+    return EXIT_SUCCESS;
+}
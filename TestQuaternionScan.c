@@ -0,0 +1,167 @@
+// TEST: gcc -std=c17 -Wall -Wextra -pthread TestQuaternionScan.c QuaternionScan.c Quaternion.c -lm -o TestQuaternionScan.exe; ./TestQuaternionScan.exe
+#include <stdlib.h>
+#include "QuaternionScan.h"
+
+#ifndef M_PI
+    #define M_PI (3.14159265358979323846)
+#endif
+#define TO_RAD(x) (x / 180.0 * M_PI)
+
+void ASSERT_SAME_DOUBLE(char* description, double x, double y)
+{
+    if(fabs(x - y) > QUATERNION_EPS) {
+        fprintf(stderr, "TEST FAILED: %s (%f != %f)\n", description, x, y);
+    }
+}
+void ASSERT_TRUE(char* description, bool check)
+{
+    if(!check) {
+        fprintf(stderr, "TEST FAILED: %s\n", description);
+    }
+}
+void ASSERT_FALSE(char* description, bool check) { ASSERT_TRUE(description, !check); }
+
+#define COUNT 10007
+
+static double w[COUNT], x[COUNT], y[COUNT], z[COUNT];
+static double sw[COUNT], sx[COUNT], sy[COUNT], sz[COUNT];
+static QuaternionArray input = {w, {x, y, z}};
+static QuaternionArray output = {sw, {sx, sy, sz}};
+
+/**
+ * Small rotations around changing axes, so that the order matters.
+ */
+static void fillInput(size_t count)
+{
+    for(size_t i = 0; i < count; i++) {
+        double axis[3] = {sin(i * 0.1), cos(i * 0.37), 0.5};
+        double len = sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+        for(int k = 0; k < 3; k++)
+            axis[k] /= len;
+        Quaternion q;
+        Quaternion_fromAxisAngle(axis, 0.01 + 0.001 * (i % 7), &q);
+        Quaternion_store(&q, &input, i);
+    }
+}
+
+/**
+ * Checks the scan against a sequential fold with Quaternion_multiply().
+ */
+static bool matchesFold(size_t count, QuaternionScanOrder order, bool exclusive)
+{
+    Quaternion product, q, result;
+    Quaternion_setIdentity(&product);
+    bool ok = true;
+    for(size_t i = 0; i < count; i++) {
+        Quaternion_load(&input, i, &q);
+        Quaternion_load(&output, i, &result);
+        if(exclusive)
+            ok &= Quaternion_equal(&result, &product);
+        if(order == QUATERNION_SCAN_RIGHT)
+            Quaternion_multiply(&product, &q, &product);
+        else
+            Quaternion_multiply(&q, &product, &product);
+        if(!exclusive)
+            ok &= Quaternion_equal(&result, &product);
+    }
+    return ok;
+}
+
+void testQuaternionScan_order(void)
+{
+    Quaternion rotX, rotZ, result, real;
+    Quaternion_fromXRotation(TO_RAD(90.0), &rotX);
+    Quaternion_fromZRotation(TO_RAD(90.0), &rotZ);
+    Quaternion_store(&rotX, &input, 0);
+    Quaternion_store(&rotZ, &input, 1);
+
+    QuaternionScanOptions options = {QUATERNION_SCAN_RIGHT, 1, 1, false};
+    QuaternionScan_reduce(&input, 2, &options, &result);
+    Quaternion_multiply(&rotX, &rotZ, &real);
+    ASSERT_TRUE("QuaternionScan_reduce with right order", Quaternion_equal(&result, &real));
+
+    options.order = QUATERNION_SCAN_LEFT;
+    QuaternionScan_reduce(&input, 2, &options, &result);
+    Quaternion_multiply(&rotZ, &rotX, &real);
+    ASSERT_TRUE("QuaternionScan_reduce with left order", Quaternion_equal(&result, &real));
+
+    Quaternion_setIdentity(&real);
+    QuaternionScan_reduce(&input, 0, NULL, &result);
+    ASSERT_TRUE("QuaternionScan_reduce of empty array", Quaternion_equal(&result, &real));
+}
+
+void testQuaternionScan_inclusive(void)
+{
+    fillInput(COUNT);
+    QuaternionScan_inclusive(&input, COUNT, NULL, &output);
+    ASSERT_TRUE("QuaternionScan_inclusive with default options", matchesFold(COUNT, QUATERNION_SCAN_RIGHT, false));
+
+    // Block sizes that do and do not divide the count, with and without threads
+    size_t blockSizes[3] = {1, 100, 5000};
+    unsigned threads[2] = {1, 3};
+    for(int b = 0; b < 3; b++) {
+        for(int t = 0; t < 2; t++) {
+            QuaternionScanOptions options = {QUATERNION_SCAN_RIGHT, threads[t], blockSizes[b], false};
+            QuaternionScan_inclusive(&input, COUNT, &options, &output);
+            ASSERT_TRUE("QuaternionScan_inclusive with right order", matchesFold(COUNT, QUATERNION_SCAN_RIGHT, false));
+            options.order = QUATERNION_SCAN_LEFT;
+            QuaternionScan_inclusive(&input, COUNT, &options, &output);
+            ASSERT_TRUE("QuaternionScan_inclusive with left order", matchesFold(COUNT, QUATERNION_SCAN_LEFT, false));
+        }
+    }
+
+    Quaternion total, last;
+    QuaternionScanOptions options = {QUATERNION_SCAN_LEFT, 4, 64, false};
+    QuaternionScan_reduce(&input, COUNT, &options, &total);
+    Quaternion_load(&output, COUNT - 1, &last);
+    ASSERT_TRUE("QuaternionScan_reduce equals the last element of the scan", Quaternion_equal(&total, &last));
+}
+
+void testQuaternionScan_exclusive(void)
+{
+    fillInput(COUNT);
+    QuaternionScanOptions options = {QUATERNION_SCAN_RIGHT, 3, 100, false};
+    QuaternionScan_exclusive(&input, COUNT, &options, &output);
+    ASSERT_TRUE("QuaternionScan_exclusive", matchesFold(COUNT, QUATERNION_SCAN_RIGHT, true));
+
+    // In place: the input is overwritten, so compare with the copy
+    for(size_t i = 0; i < COUNT; i++) {
+        Quaternion q;
+        Quaternion_load(&input, i, &q);
+        Quaternion_store(&q, &output, i);
+    }
+    QuaternionScan_exclusive(&output, COUNT, &options, &output);
+    ASSERT_TRUE("QuaternionScan_exclusive in place", matchesFold(COUNT, QUATERNION_SCAN_RIGHT, true));
+}
+
+void testQuaternionScan_normalize(void)
+{
+    // Every element is slightly too long: the product grows by about 1%
+    fillInput(COUNT);
+    for(size_t i = 0; i < COUNT; i++) {
+        w[i] *= 1 + 1e-6;
+        x[i] *= 1 + 1e-6;
+        y[i] *= 1 + 1e-6;
+        z[i] *= 1 + 1e-6;
+    }
+    Quaternion total;
+    QuaternionScanOptions options = {QUATERNION_SCAN_RIGHT, 2, 50, false};
+    QuaternionScan_reduce(&input, COUNT, &options, &total);
+    ASSERT_TRUE("QuaternionScan_reduce accumulates the norm", Quaternion_norm(&total) > 1.01);
+
+    options.normalize = true;
+    QuaternionScan_reduce(&input, COUNT, &options, &total);
+    ASSERT_SAME_DOUBLE("QuaternionScan_reduce with normalization", Quaternion_norm(&total), 1);
+    QuaternionScan_inclusive(&input, COUNT, &options, &output);
+    Quaternion_load(&output, COUNT - 1, &total);
+    ASSERT_SAME_DOUBLE("QuaternionScan_inclusive with normalization", Quaternion_norm(&total), 1);
+}
+
+int main(void)
+{
+    testQuaternionScan_order();
+    testQuaternionScan_inclusive();
+    testQuaternionScan_exclusive();
+    testQuaternionScan_normalize();
+    return EXIT_SUCCESS;
+}